@@ -0,0 +1,60 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+//! Keeps the intermediate directories from growing with every build. Renamed files get names from counters kept in memory, the files of a build directory that no loaded version of the module references are deleted after a build, and the object cache is trimmed to keep each intermediate directory under a disk usage cap.
+class BuildArtifacts {
+public:
+	//! Returns the global BuildArtifacts instance
+	static BuildArtifacts& instance();
+
+	//! Returns the next free name for the file at path, "Foo_3.pdb" for "Foo.pdb". The directory is only listed the first time, the counter is kept in memory afterwards.
+	ci::fs::path	getNextName( const ci::fs::path &path );
+	//! Deletes the files of directory that aren't in keep and don't share their stem with one of them, which keeps the .pdb, .lib and .exp files written next to a module. Files still in use are left for the next collection.
+	void			collect( const ci::fs::path &directory, const std::vector<ci::fs::path> &keep );
+	//! Deletes the least recently used files of cacheDirectory until directory, which contains it, uses at most getMaxDiskUsage() bytes
+	void			trim( const ci::fs::path &directory, const ci::fs::path &cacheDirectory );
+
+	//! Sets the number of bytes an intermediate directory can use before its object cache is trimmed, 0 to never trim it. Defaults to 1 GiB.
+	void		setMaxDiskUsage( uintmax_t maxDiskUsage ) { mMaxDiskUsage = maxDiskUsage; }
+	//! Returns the number of bytes an intermediate directory can use before its object cache is trimmed
+	uintmax_t	getMaxDiskUsage() const { return mMaxDiskUsage; }
+
+	BuildArtifacts();
+
+protected:
+	uintmax_t						mMaxDiskUsage;
+	std::mutex						mMutex;
+	//! Next number of each renamed file, by path
+	std::map<ci::fs::path, uint32_t>	mCounters;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
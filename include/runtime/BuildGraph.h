@@ -0,0 +1,105 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace runtime {
+
+//! The jobs of a module build and their dependencies. Each job is a shell command that can start once every job it depends on succeeded.
+class BuildGraph {
+public:
+	//! How a job compiling a preprocessed source runs on a build agent
+	struct RemoteCompile {
+		//! Compiler arguments, "{input}" and "{output}" stand for the paths of the source and of the object on the agent
+		std::string	arguments;
+		std::string	inputPath;
+		std::string	outputPath;
+	};
+
+	BuildGraph();
+
+	//! Adds a job running command after the jobs in dependencies, which have to be added first. Returns the index of the new job.
+	size_t				addJob( const std::string &label, const std::string &command, const std::vector<size_t> &dependencies = {} );
+	//! Adds a job standing for the build called name, which runs outside of this graph. Returns the index of the new job.
+	size_t				addExternalJob( const std::string &name );
+	//! Records the outcome of the build called name for the external jobs standing for it. Returns whether there were any.
+	bool				resolveExternalJobs( const std::string &name, bool succeeded );
+	//! Returns the names of the external builds this graph is still waiting for
+	std::vector<std::string>	getPendingExternalJobs() const;
+	//! Sets a check run when job is ready. If it returns true the job succeeds without running its command. The check runs outside of the graph when startReadyJobs() is given a list of checked jobs.
+	void				setUpToDateCheck( size_t job, const std::function<bool()> &isUpToDate ) { mJobs[job].isUpToDate = isUpToDate; }
+	//! Sets a function called right before the command of job is handed to a worker
+	void				setStartHandler( size_t job, const std::function<void()> &onStart ) { mJobs[job].onStart = onStart; }
+	//! Sets a function called when job succeeds after running its command
+	void				setSuccessHandler( size_t job, const std::function<void()> &onSuccess ) { mJobs[job].onSuccess = onSuccess; }
+	//! Lets job compile on a build agent instead of running its command
+	void				setRemoteCompile( size_t job, const RemoteCompile &remote ) { mJobs[job].remote = remote; }
+	//! Returns how job compiles on a build agent, the arguments are empty if it can't
+	const RemoteCompile&	getRemoteCompile( size_t job ) const { return mJobs[job].remote; }
+	//! Returns the text describing job in the build log, empty for jobs that shouldn't be logged
+	const std::string&	getLabel( size_t job ) const { return mJobs[job].label; }
+	//! Returns the shell command of job
+	const std::string&	getCommand( size_t job ) const { return mJobs[job].command; }
+	//! Returns the number of jobs
+	size_t				size() const { return mJobs.size(); }
+	//! Returns whether the graph has no job
+	bool				empty() const { return mJobs.empty(); }
+
+	//! Returns the jobs whose dependencies all succeeded and marks them as started. Up to date jobs are marked as succeeded instead and external jobs are never returned. Nothing starts after a failure. With checkedJobs, the ready jobs with an up to date check are added to it instead of being checked here, they stay running until finishCheck().
+	std::vector<size_t>	startReadyJobs( std::vector<size_t> *checkedJobs = nullptr );
+	//! Returns the up to date check of job
+	const std::function<bool()>&	getUpToDateCheck( size_t job ) const { return mJobs[job].isUpToDate; }
+	//! Records the outcome of the up to date check of a job returned in checkedJobs by startReadyJobs(). Returns true if the job has to run its command, it's marked as started then.
+	bool				finishCheck( size_t job, bool upToDate );
+	//! Records the outcome of a started job
+	void				finishJob( size_t job, bool succeeded );
+	//! Returns whether every job succeeded, or a job failed and none is still running
+	bool				isFinished() const;
+	//! Returns whether a job failed
+	bool				hasFailed() const { return mFailed; }
+
+protected:
+	enum class State { WAITING, CHECKING, STARTED, SUCCEEDED, FAILED };
+
+	struct Job {
+		std::string			label;
+		std::string			command;
+		std::vector<size_t>	dependencies;
+		State				state;
+		bool				external;
+		std::function<bool()>	isUpToDate;
+		std::function<void()>	onStart;
+		std::function<void()>	onSuccess;
+		RemoteCompile			remote;
+	};
+
+	std::vector<Job>	mJobs;
+	size_t				mNumRunning;
+	size_t				mNumSucceeded;
+	bool				mFailed;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -0,0 +1,193 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+//! Describes the list of Options and arguments available when building a file. The constructors are implemented by the compiler of the current platform.
+class BuildSettings {
+public:
+	BuildSettings();
+	//! Constructs the settings used to build the current project. Reads the project file if defaultSettings is true.
+	BuildSettings( bool defaultSettings );
+	//! Constructs the settings from a project file. A .vcxproj with Visual Studio, a CMake build directory or a compile_commands.json with GCC and Clang.
+	BuildSettings( const ci::fs::path &projectPath );
+
+	//! Adds an extra include folder to the compiler BuildSettings
+	BuildSettings& include( const ci::fs::path &path );
+	//! Adds an extra include folder to the compiler BuildSettings
+	BuildSettings& libraryPath( const ci::fs::path &path );
+	//! Adds an extra include folder to the compiler BuildSettings
+	BuildSettings& library( const std::string &library );
+	
+	//! Adds a preprocessor definition to the compiler BuildSettings
+	BuildSettings& define( const std::string &definition );
+	
+	//! Specifies the path to the precompiled header.
+	BuildSettings& usePrecompiledHeader( bool use = true /*const ci::fs::path &path*/ );
+	//! Specifies the path to the precompiled header.
+	BuildSettings& createPrecompiledHeader( bool create = true /*const ci::fs::path &path*/ );
+	//! Adds a forced include as the first lined of the compiled file (If you use multiple /FI options, files are included in the order they are processed by CL.)
+	BuildSettings& forceInclude( const std::string &filename );
+	//! Specifies an additional file to be compiled (and linked).
+	BuildSettings& additionalSource( const ci::fs::path &cppFile );
+	//! Specifies additional files to be compiled (and linked).
+	BuildSettings& additionalSources( const std::vector<ci::fs::path> &cppFiles );
+	//! Compiles the sources in groups of sourcesPerUnit files included by a single generated source. 0 compiles every source separately. Default to 0
+	BuildSettings& unityBuild( size_t sourcesPerUnit = 8 );
+	//! Keeps a source out of the unity build, for sources that don't compile along others. Either a path or a file name.
+	BuildSettings& unityExclude( const ci::fs::path &cppFile );
+	//! Compiles header, a name found in the include paths like "vector" or "cinder/gl/gl.h", once as a C++20 header unit shared by every module built with the same flags, and imports it instead of including it. The module is then compiled as C++20 and doesn't use a precompiled header. Ignored with Clang.
+	BuildSettings& headerUnit( const std::string &header );
+	
+	//! Specifies an object (.obj) file name or directory to be used instead of the default.
+	BuildSettings& objectFile( const ci::fs::path &path );
+	//! Specifies a file name for the program database (PDB) file created by /Z7, /Zi, /ZI (Debug Information Format).
+	BuildSettings& programDatabase( const ci::fs::path &path );
+	
+	//! Sets the output directory path
+	BuildSettings& outputPath( const ci::fs::path &path );
+	//! Sets the intermediate directory path
+	BuildSettings& intermediatePath( const ci::fs::path &path );
+	
+	//! Specifies the build configuration (Debug_Shared, Release_Shared, Release, Debug, etc...)
+	BuildSettings& configuration( const std::string &option );
+	//! Specifies the target platform (Win32 or x64)
+	BuildSettings& platform( const std::string &option );
+	//! Specifies the target platform toolset (v120, v140, v141, etc..)
+	BuildSettings& platformToolset( const std::string &option );
+			
+	//! Specifies the name of the module (.dll). Also used for path generation.
+	BuildSettings& moduleName( const std::string &name );
+	//! Specifies the typename of something that is reloadable
+	BuildSettings& typeName( const std::string &typeName );
+
+	//! Adds an obj files to be linked
+	BuildSettings& linkObj( const ci::fs::path &path );
+	//! Adds the app's generated .obj files to be linked. Default to true
+	BuildSettings& linkAppObjs( bool link );
+	//! Links against the symbols exported by the app executable instead of its .obj files, which then have to be exported by the app. Default to false
+	BuildSettings& linkHostExports( bool link = true );
+	//! Specifies the import library of the app executable used by linkHostExports. Defaults to the .lib next to the executable (Visual Studio only)
+	BuildSettings& hostImportLibrary( const ci::fs::path &path );
+	//! Reuses the objects of the translation units whose preprocessed source and compiler command didn't change. Default to true
+	BuildSettings& objectCache( bool enabled = true );
+	//! Links only the app's objects defining symbols the module needs, found through an index of the symbols of every object. Default to true
+	BuildSettings& symbolIndex( bool enabled = true );
+	//! Links the module's objects into the app with LLVM's ORC JIT instead of linking and loading a module. Only used when Runtime is built with RT_ENABLE_ORC_JIT. Default to false
+	BuildSettings& orcJit( bool enabled = true );
+	
+	//! Generates a class Factory source. Default to true
+	BuildSettings& generateFactory( bool generate );
+	
+	//! Adds an additional compiler option
+	BuildSettings& compilerOption( const std::string &option );
+	//! Adds an additional linker option
+	BuildSettings& linkerOption( const std::string &option );
+	//! Adds a user macro that will be string replaced in other settings.
+	BuildSettings& userMacro( const std::string &name, const std::string &value );
+
+	//! Enables verbose mode. Disabled by default.
+	BuildSettings& verbose( bool enabled = true );
+
+	const ci::fs::path& 	getPrecompiledHeader() const { return mPrecompiledHeader; }
+	const ci::fs::path& 	getOutputPath() const { return mOutputPath; }
+	const ci::fs::path& 	getIntermediatePath() const { return mIntermediatePath; }
+	const ci::fs::path& 	getObjectFilePath() const { return mObjectFilePath; }
+	const ci::fs::path& 	getPdbPath() const { return mPdbPath; }
+	const ci::fs::path& 	getHostImportLibrary() const { return mHostImportLibrary; }
+	const std::string&		getConfiguration() const { return mConfiguration; }
+	const std::string&		getPlatform() const { return mPlatform; }
+	const std::string&		getPlatformToolset() const { return mPlatformToolset; }
+	const std::string&		getModuleName() const { return mModuleName; }
+	const std::string&		getTypeName() const { return mTypeName; }
+
+	const std::vector<ci::fs::path>& 	getIncludes() const { return mIncludes; }
+	const std::vector<ci::fs::path>& 	getLibraryPaths() const { return mLibraryPaths; }
+	const std::vector<ci::fs::path>& 	getAdditionalSources() const { return mAdditionalSources; }
+	const std::vector<std::string>& 	getLibraries() const { return mLibraries; }
+	const std::vector<std::string>& 	getPpDefinitions() const { return mPpDefinitions; }
+	const std::vector<std::string>& 	getForcedIncludes() const { return mForcedIncludes; }
+	const std::vector<std::string>& 	getCompilerOptions() const { return mCompilerOptions; }
+	const std::vector<std::string>& 	getLinkerOptions() const { return mLinkerOptions; }
+	const std::vector<ci::fs::path>& 	getObjPaths() const { return mObjPaths; }
+	const std::vector<ci::fs::path>& 	getUnityExclusions() const { return mUnityExclusions; }
+	size_t								getUnitySize() const { return mUnitySize; }
+	const std::vector<std::string>& 	getHeaderUnits() const { return mHeaderUnits; }
+
+	const std::map<std::string, std::string>&	getUserMacros() const	{ return mUserMacros; };
+
+	bool isVerboseEnabled() const	{ return mVerbose; }
+	bool isObjectCacheEnabled() const	{ return mUseObjectCache; }
+	bool isLinkingHostExports() const	{ return mLinkHostExports; }
+	bool isSymbolIndexEnabled() const	{ return mUseSymbolIndex; }
+	bool isOrcJitEnabled() const;
+
+	//! Method meant for debugging purposes to write a pretty string of all settings
+	std::string printToString() const;
+
+protected:
+	friend class CompilerMsvc;
+	friend class CompilerGcc;
+	bool mVerbose;
+	bool mLinkAppObjs;
+	bool mLinkHostExports;
+	bool mGenerateFactory;
+	bool mGeneratePch;
+	bool mUsePch;
+	bool mUseObjectCache;
+	bool mUseSymbolIndex;
+	bool mUseOrcJit;
+	size_t mUnitySize;
+	ci::fs::path mPrecompiledHeader;
+	ci::fs::path mOutputPath;
+	ci::fs::path mIntermediatePath;
+	ci::fs::path mObjectFilePath;
+	ci::fs::path mPdbPath;
+	ci::fs::path mHostImportLibrary;
+	std::string	mConfiguration;
+	std::string	mPlatform;
+	std::string	mPlatformToolset;
+	std::string mModuleName;
+	std::string mTypeName;
+	std::vector<ci::fs::path> mIncludes;
+	std::vector<ci::fs::path> mLibraryPaths;
+	std::vector<ci::fs::path> mAdditionalSources;
+	std::vector<std::string> mLibraries;
+	std::vector<std::string> mPpDefinitions;
+	std::vector<std::string> mForcedIncludes;
+	std::vector<std::string> mCompilerOptions;
+	std::vector<std::string> mLinkerOptions;
+	std::vector<ci::fs::path> mObjPaths;
+	std::vector<ci::fs::path> mUnityExclusions;
+	std::vector<std::string> mHeaderUnits;
+	std::map<std::string, std::string>	mUserMacros;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
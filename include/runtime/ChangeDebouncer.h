@@ -0,0 +1,72 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+//! Merges the file changes of a module arriving within a quiet window into a single rebuild request
+class ChangeDebouncer {
+public:
+	using FlushFn = std::function<void( const std::vector<ci::fs::path>& )>;
+
+	//! Returns the global ChangeDebouncer instance
+	static ChangeDebouncer& instance();
+
+	//! Records a change of file for the module called key. flushFn is called on the main thread with every file changed once no change for key has happened during the quiet window. The last flushFn pushed for key is the one called.
+	void push( const std::string &key, const ci::fs::path &file, const FlushFn &flushFn );
+	//! Sets the time without changes to wait for before flushing a module. Zero flushes every change right away.
+	void setQuietWindow( std::chrono::milliseconds window ) { mQuietWindow = window; }
+	//! Returns the time without changes to wait for before flushing a module
+	std::chrono::milliseconds getQuietWindow() const { return mQuietWindow; }
+
+	ChangeDebouncer();
+	~ChangeDebouncer();
+
+protected:
+	struct Changes {
+		std::vector<ci::fs::path>				files;
+		FlushFn									flushFn;
+		std::chrono::steady_clock::time_point	deadline;
+	};
+
+	void timerThread();
+
+	std::chrono::milliseconds				mQuietWindow;
+	std::map<std::string,Changes>			mChanges;
+	std::mutex								mMutex;
+	std::condition_variable					mCondition;
+	bool									mStop;
+	std::unique_ptr<std::thread>			mThread;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
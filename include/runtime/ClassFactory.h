@@ -4,8 +4,8 @@
 
 namespace runtime {
 
-//! Generates the object factory file with a set of extern "C" functions allowing instancing of the class
-void generateClassFactory( const ci::fs::path &outputPath, const std::string &className, const std::string &headerName = "" );
+//! Generates the object factory file exporting the manifest of the module, which describes the class and gives the functions allowing its instancing. headerPath is the header declaring the class, its data members make the layout hash. The file is only written when its content changes.
+void generateClassFactory( const ci::fs::path &outputPath, const std::string &className, const ci::fs::path &headerPath );
 
 } // namespace runtime
 
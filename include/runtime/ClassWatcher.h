@@ -5,9 +5,15 @@
 #include "cinder/Exception.h"
 #include "cinder/Filesystem.h"
 #include "cinder/FileWatcher.h"
+#include "cinder/Log.h"
 
 #include "runtime/Module.h"
-#include "runtime/CompilerMsvc.h"
+#include "runtime/Epoch.h"
+#include "runtime/ModuleResidency.h"
+#include "runtime/BuildArtifacts.h"
+#include "runtime/Compiler.h"
+#include "runtime/ChangeDebouncer.h"
+#include "runtime/DependencyIndex.h"
 
 #if defined( CEREAL_CEREAL_HPP_ )
 #include <cereal/details/traits.hpp>
@@ -33,13 +39,19 @@ static std::string stripNamespace( const std::string &className )
 template<class T>
 class ClassWatcher {
 public:
+	ClassWatcher() : mLayoutHash( 0 )
+	{
+		// the module retires its versions and leaves the loaded modules when the watcher is destroyed, both are constructed first so that they outlive the watcher
+		Epoch::instance();
+		ModuleResidency::instance();
+	}
 	
 	//! Returns the global ClassWatcher instance
 	static ClassWatcher& instance();
 	
 	//! Adds an instance to the ClassWatcher watch list
 	void watch( T* ptr, const std::string &name, const std::vector<ci::fs::path> &filePaths, const ci::fs::path &dllPath, rt::Compiler::BuildSettings settings = rt::Compiler::BuildSettings( true ) );
-	//! Removes an instance from ClassWatcher watch list
+	//! Removes an instance from ClassWatcher watch list. Called by the operator delete of the class, except for instances already using a version of the module: their deleting destructor comes from the module, which doesn't know about the watcher. Call unwatch() before deleting those, or the module is never considered idle and the next build updates freed memory.
 	void unwatch( T* ptr );
 
 	enum class Method { RECONSTRUCT, SWAP_VTABLE };
@@ -56,7 +68,7 @@ public:
 		//! Adds an extra include folder to the compiler BuildSettings
 		Options& method( Method method ) { mMethod = method; return *this; }
 		//! Adds an extra include folder to the compiler BuildSettings
-		Options& buildSettings( const CompilerMsvc::BuildSettings &buildSettings ) { mBuildSettings = buildSettings; return *this; }
+		Options& buildSettings( const Compiler::BuildSettings &buildSettings ) { mBuildSettings = buildSettings; return *this; }
 		
 		//! Adds an extra include folder to the compiler BuildSettings
 		// Options& additionalSources( bool watch = true );
@@ -67,7 +79,7 @@ public:
 		std::string					mClassName;
 		ci::fs::path				mSources;
 		Method						mMethod;
-		CompilerMsvc::BuildSettings mBuildSettings;
+		Compiler::BuildSettings mBuildSettings;
 		friend class ClassWatcher<T>;
 	};
 	
@@ -87,6 +99,15 @@ public:
 	void			setOptions( const Options& options ) { mOptions = options; }
 protected:
 	
+	//! Builds the module after changedFiles have been modified and updates the instances
+	void build( const ci::fs::path &source, const rt::Compiler::BuildSettings &settings, const std::vector<ci::fs::path> &changedFiles );
+	//! Queues a build of the module after file changed
+	void onFileChanged( const ci::fs::path &source, const rt::Compiler::BuildSettings &settings, const ci::fs::path &file );
+	//! Rebuilds the module when one of the headers included by its sources changes
+	void watchDependencies( const ci::fs::path &source, const rt::Compiler::BuildSettings &settings, const std::vector<ci::fs::path> &dependencies );
+	//! Returns the file listing the headers the module depended on at its last build
+	static ci::fs::path getDependenciesPath( const rt::Compiler::BuildSettings &settings ) { return settings.getIntermediatePath() / "runtime" / settings.getModuleName() / ( settings.getModuleName() + ".deps" ); }
+	
 	template<typename, typename C>
 	struct hasPreRuntimeBuild {
 		static_assert( std::integral_constant<C, false>::value, "Second template parameter needs to be of function type." );
@@ -137,7 +158,10 @@ protected:
 
 	Options			mOptions;
 	rt::ModulePtr	mModule;
+	//! Layout hash of the class in the version of the module the instances use, 0 while they use the app's
+	uint64_t		mLayoutHash;
 	std::vector<T*> mInstances;
+	std::vector<ci::fs::path>	mFilePaths;
 };
 
 class ClassWatcherException : public ci::Exception {
@@ -156,6 +180,11 @@ template<class T>
 void ClassWatcher<T>::watch( T* ptr, const std::string &name, const std::vector<ci::fs::path> &filePaths, const ci::fs::path &dllPath, rt::Compiler::BuildSettings settings = rt::Compiler::BuildSettings( true ) )
 {
 	mInstances.push_back( static_cast<T*>( ptr ) );
+	bool firstInstance = mInstances.size() == 1;
+	// new instances are constructed with the code the app was compiled with
+	if( firstInstance ) {
+		mLayoutHash = 0;
+	}
 
 	if( settings.getModuleName().empty() ) {
 		settings.moduleName( stripNamespace( name ) );
@@ -172,82 +201,189 @@ void ClassWatcher<T>::watch( T* ptr, const std::string &name, const std::vector<
 		mModule = std::make_unique<rt::Module>( dllPath );
 
 		ci::fs::path source = filePaths.front();
+		mFilePaths = filePaths;
 		ci::FileWatcher::instance().watch( filePaths, 
 			ci::FileWatcher::Options().callOnWatch( false ),
-			[&,source,settings,name]( const ci::WatchEvent &event ) {  
-				// unlock the dll-handle before building
-				mModule->unlockHandle();
-				
-				// force precompiled-header re-generation on header change
-				rt::Compiler::BuildSettings buildSettings = settings;
-				if( event.getFile().extension() == ".h" ) {
-					buildSettings.createPrecompiledHeader();
-				}
-
-				auto vtableSym = rt::CompilerMsvc::instance().getSymbolForVTable( buildSettings.getTypeName() );
-
-				// initiate the build
-				rt::CompilerMsvc::instance().build( source, buildSettings, [&,event,buildSettings, vtableSym]( const rt::CompilationResult &result ) {
-					// if a new dll exists update the handle
-					if( ci::fs::exists( mModule->getPath() ) ) {
-						mModule->getCleanupSignal().emit( *mModule );
-						mModule->updateHandle();
-
-						if( event.getFile().extension() == ".cpp" ) {
-							// Find the address of the vtable
-							if( void* vtableAddress = mModule->getSymbolAddress( vtableSym ) ) {
-								for( size_t i = 0; i < mInstances.size(); ++i ) {
-									callPreRuntimeBuild( mInstances[i] );
-								#if defined( CEREAL_CEREAL_HPP_ )
-									std::stringstream archiveStream;
-									cereal::BinaryOutputArchive outputArchive( archiveStream );
-									serialize( outputArchive, mInstances[i] );
-								#endif
-									*(void **)mInstances[i] = vtableAddress;
-									callPostRuntimeBuild( mInstances[i] );
-								#if defined( CEREAL_CEREAL_HPP_ )
-									cereal::BinaryInputArchive inputArchive( archiveStream );
-									serialize( inputArchive, mInstances[i] );
-								#endif
-								}
-							}
-						}
-						else if( event.getFile().extension() == ".h" ){
-							if( auto placementNewOperator = static_cast<T*(__cdecl*)(T*)>( mModule->getSymbolAddress( "rt_placement_new_operator" ) ) ) {
-								// use placement new to construct new instances at the current instances addresses
-								for( size_t i = 0; i < mInstances.size(); ++i ) {
-									callPreRuntimeBuild( mInstances[i] );
-								#if defined( CEREAL_CEREAL_HPP_ )
-									std::stringstream archiveStream;
-									cereal::BinaryOutputArchive outputArchive( archiveStream );
-									serialize( outputArchive, mInstances[i] );
-								#endif
-									mInstances[i]->~T();
-									placementNewOperator( mInstances[i] );
-									callPostRuntimeBuild( mInstances[i] );
-								#if defined( CEREAL_CEREAL_HPP_ )
-									cereal::BinaryInputArchive inputArchive( archiveStream );
-									serialize( inputArchive, mInstances[i] );
-								#endif
-								}
-							}
-						}
-						
-						mModule->getChangedSignal().emit( *mModule );
-					}
-					else {
-						throw ClassWatcherException( "Module " + buildSettings.getModuleName() + " not found at " + mModule->getPath().string() );
-					}
-				} );
+			[&,source,settings]( const ci::WatchEvent &event ) {
+				onFileChanged( source, settings, event.getFile() );
 			} 
 		);
+
+		// headers recorded by a previous session until the next build lists them again
+		watchDependencies( source, settings, DependencyIndex::load( getDependenciesPath( settings ) ) );
+	}
+
+	// the module is only loaded while it has instances, the watches and its last build stay when it's unloaded
+	if( firstInstance && mModule->load() && mModule->isLoaded() ) {
+		ModuleResidency::instance().touch( *mModule, [this]() { return mInstances.empty(); } );
+	}
+}
+
+template<class T>
+void ClassWatcher<T>::onFileChanged( const ci::fs::path &source, const rt::Compiler::BuildSettings &settings, const ci::fs::path &file )
+{
+	// changes to the same module arriving close to each other result in a single build
+	rt::ChangeDebouncer::instance().push( settings.getModuleName(), file, [&,source,settings]( const std::vector<ci::fs::path> &changedFiles ) {
+		build( source, settings, changedFiles );
+	} );
+}
+
+template<class T>
+void ClassWatcher<T>::watchDependencies( const ci::fs::path &source, const rt::Compiler::BuildSettings &settings, const std::vector<ci::fs::path> &dependencies )
+{
+	// the module's own files are already watched
+	std::vector<ci::fs::path> headers;
+	for( const auto &dependency : dependencies ) {
+		if( std::none_of( mFilePaths.begin(), mFilePaths.end(), [&dependency]( const ci::fs::path &file ) { return file.lexically_normal() == dependency.lexically_normal(); } ) ) {
+			headers.push_back( dependency );
+		}
 	}
+	DependencyIndex::instance().setDependencies( settings.getModuleName(), headers, [&,source,settings]( const ci::fs::path &header ) {
+		onFileChanged( source, settings, header );
+	} );
+}
+
+template<class T>
+void ClassWatcher<T>::build( const ci::fs::path &source, const rt::Compiler::BuildSettings &settings, const std::vector<ci::fs::path> &changedFiles )
+{
+	// an included header can change the types of the members, the instances are then reconstructed. Edits of the class's own header only
+	// reconstruct them if its layout hash changed, or if it isn't known yet. Included headers don't always end with .h
+	auto isSource = []( const ci::fs::path &file ) { return file.extension() == ".cpp" || file.extension() == ".cc" || file.extension() == ".cxx"; };
+	auto isOwnFile = [this]( const ci::fs::path &file ) { return std::any_of( mFilePaths.begin(), mFilePaths.end(), [&file]( const ci::fs::path &own ) { return own.lexically_normal() == file.lexically_normal(); } ); };
+	bool headerChanged = std::any_of( changedFiles.begin(), changedFiles.end(), [&]( const ci::fs::path &file ) { return ! isSource( file ) && ! isOwnFile( file ); } );
+	bool ownHeaderChanged = std::any_of( changedFiles.begin(), changedFiles.end(), [&]( const ci::fs::path &file ) { return ! isSource( file ) && isOwnFile( file ); } );
+	bool sourceChanged = std::any_of( changedFiles.begin(), changedFiles.end(), isSource );
+
+	// the compiler rebuilds the precompiled header itself if one of the headers it is made of changed
+	rt::Compiler::BuildSettings buildSettings = settings;
+	// every build is a new version of the module, the loaded one is never overwritten
+	buildSettings.outputPath( mModule->getNextPath() );
+
+#if defined( CINDER_MSW )
+	using PlacementNewOperator = T*(__cdecl*)(T*);
+#else
+	using PlacementNewOperator = T*(*)(T*);
+#endif
+
+	// initiate the build
+	rt::Compiler::instance().build( source, buildSettings, [&,source,settings,headerChanged,ownHeaderChanged,sourceChanged,buildSettings]( const rt::CompilationResult &result ) {
+		// the headers the sources include now are the ones that rebuild the module next time. Objects fetched from the cache
+		// don't report their includes, a build that reported none keeps the previous set rather than dropping its watches
+		if( ! result.getDependencies().empty() ) {
+			watchDependencies( source, settings, result.getDependencies() );
+			DependencyIndex::instance().save( settings.getModuleName(), getDependenciesPath( settings ) );
+		}
+
+		// if a new dll exists update the handle, with the ORC JIT the objects are linked in the app instead
+		bool linkedInApp = buildSettings.isOrcJitEnabled();
+	#if defined( RT_ENABLE_ORC_JIT )
+		// the instances keep using the previous version if the objects can't be linked
+		if( linkedInApp && ! mModule->updateObjects( result.getObjectFilePaths() ) ) {
+			return;
+		}
+	#endif
+		if( linkedInApp || ci::fs::exists( mModule->getNextPath() ) ) {
+			mModule->getCleanupSignal().emit( *mModule );
+			if( ! linkedInApp ) {
+				mModule->updateHandle();
+			}
+
+			// a single lookup when the module has loaded, the ones without a manifest can only export their constructor
+			PlacementNewOperator placementNewOperator = nullptr;
+			const void* (*getVTable)() = nullptr;
+			bool layoutChanged = ownHeaderChanged && mLayoutHash == 0;
+			if( const auto *manifest = mModule->getClassManifest( buildSettings.getTypeName() ) ) {
+				// the instances live in storage allocated for the class the app was compiled with
+				if( manifest->size > sizeof( T ) || manifest->alignment > alignof( T ) ) {
+					CI_LOG_E( buildSettings.getTypeName() << " doesn't fit in its instances anymore (" << manifest->size << " bytes instead of " << sizeof( T ) << "), restart the app to use the new version" );
+					return;
+				}
+				placementNewOperator = reinterpret_cast<PlacementNewOperator>( manifest->placementNewOperator );
+				getVTable = manifest->vtable;
+				layoutChanged = layoutChanged || ( mLayoutHash != 0 && manifest->layoutHash != mLayoutHash );
+				mLayoutHash = manifest->layoutHash;
+			}
+			else {
+				placementNewOperator = reinterpret_cast<PlacementNewOperator>( mModule->getSymbolAddress( "rt_placement_new_operator" ) );
+				mLayoutHash = 0;
+			}
+
+			// a new layout needs the instances constructed again
+			if( headerChanged || layoutChanged ) {
+				if( placementNewOperator ) {
+					// use placement new to construct new instances at the current instances addresses
+					for( size_t i = 0; i < mInstances.size(); ++i ) {
+						callPreRuntimeBuild( mInstances[i] );
+					#if defined( CEREAL_CEREAL_HPP_ )
+						std::stringstream archiveStream;
+						cereal::BinaryOutputArchive outputArchive( archiveStream );
+						serialize( outputArchive, mInstances[i] );
+					#endif
+						mInstances[i]->~T();
+						placementNewOperator( mInstances[i] );
+						callPostRuntimeBuild( mInstances[i] );
+					#if defined( CEREAL_CEREAL_HPP_ )
+						cereal::BinaryInputArchive inputArchive( archiveStream );
+						serialize( inputArchive, mInstances[i] );
+					#endif
+					}
+				}
+			}
+			else if( sourceChanged || ownHeaderChanged ) {
+				// only asked for now, getting it constructs an instance
+				void* vtableAddress = getVTable ? const_cast<void*>( getVTable() ) : nullptr;
+				if( ! vtableAddress ) {
+					CI_LOG_W( "The module of " << buildSettings.getTypeName() << " doesn't give a vtable, its instances keep using their current version" );
+				}
+				else {
+					for( size_t i = 0; i < mInstances.size(); ++i ) {
+						callPreRuntimeBuild( mInstances[i] );
+					#if defined( CEREAL_CEREAL_HPP_ )
+						std::stringstream archiveStream;
+						cereal::BinaryOutputArchive outputArchive( archiveStream );
+						serialize( outputArchive, mInstances[i] );
+					#endif
+						*(void **)mInstances[i] = vtableAddress;
+						callPostRuntimeBuild( mInstances[i] );
+					#if defined( CEREAL_CEREAL_HPP_ )
+						cereal::BinaryInputArchive inputArchive( archiveStream );
+						serialize( inputArchive, mInstances[i] );
+					#endif
+					}
+				}
+			}
+						
+			mModule->getChangedSignal().emit( *mModule );
+
+			// the build directory only keeps this build and the versions still loaded, unless a newer build is writing to it already
+			if( ! rt::Compiler::instance().isBuilding( buildSettings.getModuleName() ) ) {
+				auto artifacts = result.getObjectFilePaths();
+				artifacts.push_back( mModule->getPath() );
+				artifacts.push_back( mModule->getTempPath() );
+				artifacts.push_back( result.getPdbFilePath() );
+				BuildArtifacts::instance().collect( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build", artifacts );
+				BuildArtifacts::instance().trim( settings.getIntermediatePath() / "runtime", settings.getIntermediatePath() / "runtime" / "cache" );
+			}
+			// the instances use the new version, the previous one goes once no registered thread can be running it
+			mModule->releasePreviousHandle();
+			// a module built without instances is unloaded right away unless there's room for it
+			if( mModule->isLoaded() ) {
+				ModuleResidency::instance().touch( *mModule, [this]() { return mInstances.empty(); } );
+			}
+		}
+		else {
+			throw ClassWatcherException( "Module " + buildSettings.getModuleName() + " not found at " + mModule->getNextPath().string() );
+		}
+	} );
 }
 
 template<class T>
 void ClassWatcher<T>::unwatch( T* ptr )
 {
 	mInstances.erase( std::remove( mInstances.begin(), mInstances.end(), ptr ), mInstances.end() );
+	if( mInstances.empty() ) {
+		ModuleResidency::instance().trim();
+	}
 }
 
 // --------------------------------------------------------------
@@ -257,7 +393,7 @@ void ClassWatcher<T>::unwatch( T* ptr )
 static ci::fs::path makeDllPath( const ci::fs::path &intermediatePath, const char *className )
 {
 	auto strippedClassName = stripNamespace( className );
-	return intermediatePath / "runtime" / strippedClassName / "build" / ( strippedClassName + ".dll" );
+	return intermediatePath / "runtime" / strippedClassName / "build" / ( strippedClassName + rt::Compiler::getModuleExtension() );
 }
 
 template<class Class>
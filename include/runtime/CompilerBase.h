@@ -22,41 +22,25 @@
 
 #include <memory>
 #include <functional>
+#include <string_view>
+#include <deque>
+#include <map>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
 
 #include "cinder/Exception.h"
 #include "cinder/Filesystem.h"
-#include "cinder/signals.h"
+
+#include "runtime/LineBuffer.h"
+#include "runtime/BuildGraph.h"
 
 using ProcessPtr = std::unique_ptr<class Process>;
 
 namespace runtime {
 
-class CompilationResult;
-
-class CompilerBase {
-public:
-	CompilerBase();
-	virtual ~CompilerBase();
-	
-	//! Compiles and links the file at path. A callback can be specified to get the compilation results.
-	virtual void build( const std::string &arguments, const std::function<void(const CompilationResult&)> &onBuildFinish = nullptr ) {}
-	
-protected:
-	virtual std::string		getCLInitCommand() const = 0;
-	virtual ci::fs::path	getCLInitPath() const = 0;
-	virtual ci::fs::path	getCompilerPath() const = 0;
-	virtual std::string		getCompilerInitArgs() const = 0;
-
-	virtual void parseProcessOutput();
-	void initializeProcess();
-
-	ProcessPtr								mProcess;
-	ci::signals::ScopedConnection			mProcessOutputConnection;
-	bool									mVerbose;
-	std::vector<std::string>				mErrors;
-	std::vector<std::string>				mWarnings;
-};
-
 class CompilationResult {
 public:
 	//! Returns the path of the compilation output
@@ -81,6 +65,10 @@ public:
 	const std::vector<std::string>& getWarnings() const;
 	//! Returns the list of warnings
 	std::vector<std::string>&		getWarnings();
+	//! Returns the headers included by the compiled files, system headers excluded
+	const std::vector<ci::fs::path>&	getDependencies() const;
+	//! Returns the headers included by the compiled files, system headers excluded
+	std::vector<ci::fs::path>&			getDependencies();
 	
 	//! Returns the path of the compilation output
 	void setOutputPath( const ci::fs::path &path );
@@ -96,6 +84,176 @@ protected:
 	std::vector<ci::fs::path> mObjectFilePaths;
 	std::vector<std::string> mErrors;
 	std::vector<std::string> mWarnings;
+	std::vector<ci::fs::path> mDependencies;
+};
+
+class CompilerBase {
+public:
+	CompilerBase();
+	virtual ~CompilerBase();
+	
+	//! Compiles and links the file at path. A callback can be specified to get the compilation results.
+	virtual void build( const std::string &arguments, const std::function<void(const CompilationResult&)> &onBuildFinish = nullptr ) {}
+	
+	//! Returns the most recent lines of compiler output. Older output is discarded to keep memory bounded.
+	std::string getOutputHistory() const;
+	//! Returns whether the build called name is queued or running
+	bool isBuilding( const std::string &name ) const { return mBuilds.count( name ) > 0; }
+
+	//! Sets the maximum number of compiler processes building concurrently. Defaults to half the number of cores.
+	void	setNumWorkers( size_t count );
+	//! Returns the maximum number of compiler processes building concurrently
+	size_t	getNumWorkers() const { return mNumWorkers; }
+
+	//! Hands the jobs to a long-lived compile server started with command in each compiler shell instead of starting the compiler for every job, so the server can keep parsed headers in memory between builds. An empty command goes back to running the compiler directly. See the README for the protocol.
+	void				setCompileServer( const std::string &command );
+	//! Returns the command starting the compile server, empty if the compiler runs directly
+	const std::string&	getCompileServer() const { return mCompileServer; }
+
+	//! Compiles the translation units missing from the object cache on the build agent listening at address ("host:port"), through the rt-build-agent client at clientPath (see tools/BuildAgent). They compile locally when the agent doesn't respond. An empty address compiles everything locally.
+	void				setBuildAgent( const std::string &address, const ci::fs::path &clientPath = "rt-build-agent" );
+	//! Returns the address of the build agent, empty if everything compiles locally
+	const std::string&	getBuildAgent() const { return mBuildAgent; }
+
+protected:
+	enum class BuildMarker { BEGIN, END };
+
+	//! A compiler shell process and the diagnostics of the job it is running. The output and diagnostics are owned by the reader thread while a job runs.
+	struct Worker {
+		Worker();
+		~Worker();
+
+		uint64_t					id;
+		size_t						index;
+		ProcessPtr					process;
+		LineBuffer					outputLines;
+		bool						busy;
+		std::atomic<bool>			cancelled;
+		std::string					buildName;
+		size_t						job;
+		std::string					compileServer;
+		bool						compileServerReady;
+		std::vector<std::string>	errors;
+		std::vector<std::string>	warnings;
+		std::vector<std::string>	dependencies;
+	};
+	using WorkerPtr = std::unique_ptr<Worker>;
+
+	struct PendingJob {
+		std::string	buildName;
+		size_t		job;
+		std::string	command;
+	};
+
+	virtual std::string		getCLInitCommand() const = 0;
+	virtual ci::fs::path	getCLInitPath() const = 0;
+	virtual ci::fs::path	getCompilerPath() const = 0;
+	virtual std::string		getCompilerInitArgs() const = 0;
+	//! Returns the shell expression expanding to the exit code of the last command
+	virtual std::string		getShellStatusVariable() const { return "$?"; }
+	//! Returns the shell operator running a command after the previous one exits
+	virtual std::string		getShellCommandSeparator() const { return ";"; }
+	//! Returns a shell command running command, then fallback if command exited with status. Its exit code is the one of the last command run.
+	virtual std::string		getShellFallbackCommand( const std::string &command, int status, const std::string &fallback ) const;
+
+	//! Returns a shell command printing a length-prefixed marker framing the output of the build called name
+	std::string getBuildMarkerCommand( BuildMarker marker, const std::string &name ) const;
+
+	//! Queues command as a job of the build called name ahead of older pending jobs. It runs on the first idle worker, a new worker is started if needed and allowed.
+	void dispatch( const std::string &name, const std::string &command, size_t job = 0 );
+	//! Queues the jobs of the build called name that are ready to run. Their up to date checks run on the check threads.
+	void dispatchReadyJobs( const std::string &name );
+	//! Queues the up to date check of job for the check threads, its outcome goes to onCheckFinished()
+	void runUpToDateCheck( const std::string &name, uint64_t buildId, size_t job, const std::function<bool()> &isUpToDate );
+	//! Runs queued up to date checks until the compiler is destroyed
+	void checkThread();
+	//! Hands the outcomes of the finished up to date checks to onCheckFinished(). Called on the main thread.
+	void deliverFinishedChecks();
+	//! Called on the main thread when the up to date check of job is done. Ignored if the build it belongs to has been superseded.
+	void onCheckFinished( const std::string &name, uint64_t buildId, size_t job, bool upToDate );
+	//! Drops the pending jobs of the build called name and kills the workers running the others. Returns whether something was cancelled.
+	bool cancel( const std::string &name );
+	//! Hands pending jobs to idle workers
+	void dispatchPendingJobs();
+	//! Returns an idle worker, starting a new one if every worker is busy and the pool isn't full. Returns nullptr otherwise.
+	Worker* getIdleWorker();
+	//! Starts a new compiler shell process
+	WorkerPtr createWorker();
+	//! Kills the process of worker and replaces it with a new one. The old worker is destroyed on the next main loop iteration.
+	void replaceWorker( WorkerPtr &worker );
+	//! Returns the shell command starting the compile server, followed by a marker telling it exited
+	std::string getCompileServerCommand() const;
+	//! Returns the shell command running job, on the build agent if there's one and the job can compile there
+	std::string getShellCommand( const PendingJob &job ) const;
+
+	//! Splits a chunk of the output of worker into lines and parses them. Called on the reader thread.
+	void parseOutput( Worker &worker, const char* data, size_t size );
+	//! Runs fn on the main thread if the worker with this id is still alive and hasn't been cancelled by then
+	void postToWorker( uint64_t workerId, const std::function<void( Worker& )> &fn );
+	//! Called on the reader thread for every complete line of compiler output that isn't a build marker
+	virtual void parseLine( Worker &worker, std::string_view line );
+	//! Called on the main thread when the begin marker of a job of the build called name is reached
+	virtual void onJobStarted( Worker &worker, std::string_view name );
+	//! Called on the main thread when the end marker of a job of the build called name is reached, status is the exit code of the job's command
+	virtual void onJobFinished( Worker &worker, std::string_view name, int status );
+	//! Called on the main thread once every job of the build called name succeeded or a job failed and the others stopped. worker ran the last job.
+	virtual void onBuildFinished( Worker &worker, const std::string &name );
+	//! Called on the main thread when the compile server of worker exits. Fails the job it was running and replaces the worker.
+	virtual void onCompileServerExited( Worker &worker );
+	//! Called on the main thread when the build agent at address didn't respond. Compiles everything locally from then on.
+	virtual void onBuildAgentUnavailable( const std::string &address );
+	//! Called when the build called name is cancelled before reaching its end marker
+	virtual void onBuildCancelled( const std::string &name );
+	//! Returns the project and configuration printed when a build starts
+	virtual std::string getBuildDescription() const { return ""; }
+	//! Registers the result and callback of the build called name and queues the jobs of graph that can start. External jobs of graph wait for the builds they are named after, if they are still running.
+	void queueBuild( const std::string &name, const BuildGraph &graph, const CompilationResult &result, const std::function<void(const CompilationResult&)> &onBuildFinish );
+	//! Hands the outcome of the build called name to the builds waiting for it
+	void resolveDependentBuilds( Worker &worker, const std::string &name, bool succeeded );
+	//! Skips the jobs of the build called name that haven't reached a worker yet, once the build has failed
+	void dropPendingJobs( const std::string &name, BuildGraph &graph );
+	//! Returns the string stored in the errors and warnings list for a line of output
+	virtual std::string formatDiagnostic( std::string_view line ) const { return std::string( line ); }
+	void initializeProcess();
+
+	struct Build {
+		CompilationResult								result;
+		std::function<void(const CompilationResult&)>	onBuildFinish;
+		std::chrono::steady_clock::time_point			startTime;
+		BuildGraph										graph;
+		bool											started;
+		//! Identifies this build among the ones with the same name, 0 once cancelled
+		uint64_t										id;
+	};
+	using BuildMap = std::map<std::string,Build>;
+
+	struct Check {
+		std::string				name;
+		uint64_t				buildId;
+		size_t					job;
+		std::function<bool()>	isUpToDate;
+		bool					upToDate;
+	};
+
+	BuildMap								mBuilds;
+	std::vector<WorkerPtr>					mWorkers;
+	std::vector<WorkerPtr>					mCancelledWorkers;
+	size_t									mNumWorkers;
+	std::deque<PendingJob>					mPendingJobs;
+	uint64_t								mNextWorkerId;
+	uint64_t								mNextBuildId;
+	std::string								mCompileServer;
+	std::string								mBuildAgent;
+	ci::fs::path							mBuildAgentClient;
+	bool									mVerbose;
+	mutable std::mutex						mOutputHistoryMutex;
+	LineHistory								mOutputHistory;
+	std::vector<std::thread>				mCheckThreads;
+	std::deque<Check>						mChecks;
+	std::deque<Check>						mFinishedChecks;
+	std::mutex								mCheckMutex;
+	std::condition_variable					mCheckCondition;
+	bool									mStopChecks;
 };
 
 class CompilerException : public ci::Exception {
@@ -0,0 +1,96 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include "runtime/CompilerBase.h"
+#include "runtime/BuildSettings.h"
+#include "runtime/PrecompiledHeader.h"
+
+namespace runtime {
+
+using CompilerGccRef = std::shared_ptr<class CompilerGcc>;
+using CompilerGccPtr = std::unique_ptr<class CompilerGcc>;
+
+//! Builds modules as shared objects with g++ or clang++. The compiler can be changed with the RT_CXX or CXX environment variables.
+class CompilerGcc : public CompilerBase {
+public:
+	CompilerGcc();
+	~CompilerGcc();
+
+	static CompilerGcc& instance();
+	
+	using BuildSettings = runtime::BuildSettings;
+
+	void build( const std::string &arguments, const std::function<void(const CompilationResult&)> &onBuildFinish = nullptr ) override;
+	void build( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::function<void(const CompilationResult&)> &onBuildFinish = nullptr );
+	void build( const std::vector<ci::fs::path> &sourcesPaths, const BuildSettings &settings, const std::function<void(const CompilationResult&)> &onBuildFinish = nullptr );
+
+	//! Returns the extension of the modules built by this compiler
+	static std::string getModuleExtension() { return ".so"; }
+	//! Returns whether the compiler is clang, which uses -include-pch instead of looking for .gch files
+	bool isClang() const { return mIsClang; }
+
+	//! Method meant for debugging purposes to write a pretty string of all settings
+	std::string printToString() const;
+	//! This logs Compiler, ProjectConfiguration, and BuildSettings to ci::log
+	void debugLog( BuildSettings *settings = nullptr ) const;
+
+protected:
+	//! Returns the path of the compiled pooled precompiled header entry
+	ci::fs::path getPrecompiledHeaderOutputPath( const PrecompiledHeaderPool::Entry &entry ) const;
+	//! Returns the command creating the pooled precompiled header entry, extracted from the sources in sourceDir
+	std::string generatePrecompiledHeaderCommand( const PrecompiledHeaderPool::Entry &entry, const ci::fs::path &sourceDir, const BuildSettings &settings ) const;
+	//! Finds the shared precompiled header of the module and queues its build if it is missing. Returns the name of the build to wait for, or an empty string if the module doesn't use one. pchFlags receives the flags using it and pchEntry its entry.
+	std::string queuePrecompiledHeader( const ci::fs::path &sourcePath, const BuildSettings &settings, std::string *pchFlags, PrecompiledHeaderPool::Entry *pchEntry );
+	//! Returns the command compiling the header of entry as a header unit in its directory
+	std::string generateHeaderUnitCommand( const PrecompiledHeaderPool::Entry &entry, const BuildSettings &settings ) const;
+	//! Finds the shared header units of the module and queues the builds of the missing ones. Returns the names of the builds to wait for, empty if the module doesn't use header units. headerUnitFlags receives the flags importing them.
+	std::vector<std::string> queueHeaderUnits( const BuildSettings &settings, std::string *headerUnitFlags );
+	//! Returns the command compiling the single translation unit at sourcePath into objectPath
+	std::string generateCompilerCommand( const ci::fs::path &sourcePath, const ci::fs::path &objectPath, const BuildSettings &settings, const std::string &pchFlags ) const;
+	//! Returns the command writing the preprocessed translation unit at sourcePath to preprocessedPath
+	std::string generatePreprocessorCommand( const ci::fs::path &sourcePath, const ci::fs::path &preprocessedPath, const BuildSettings &settings ) const;
+	//! Returns the arguments compiling the preprocessed translation unit at inputPath to outputPath, locally on a cache miss or on a build agent
+	std::string generatePreprocessedCompilerArguments( const std::string &inputPath, const std::string &outputPath, const BuildSettings &settings ) const;
+	std::string generateLinkerCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, CompilationResult* result ) const;
+	//! Returns the path of the response file listing the app objects linked into the module
+	ci::fs::path getAppObjectsResponsePath( const BuildSettings &settings ) const;
+	//! Returns the jobs building the module: every translation unit in parallel once the builds called pchBuildNames are done, then the link. pchFlags use the precompiled header or the header units.
+	BuildGraph	generateBuildGraph( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::vector<std::string> &pchBuildNames, const std::string &pchFlags, CompilationResult* result ) const;
+	//! Returns the compiler flags shared by the precompiled header and the sources, they have to match for the precompiled header to be used
+	std::string generateCompilerFlags( const BuildSettings &settings ) const;
+
+	//! Collects the headers listed by the preprocessor and passes the other lines on
+	void		parseLine( Worker &worker, std::string_view line ) override;
+	std::string formatDiagnostic( std::string_view line ) const override;
+	std::string getBuildDescription() const override;
+
+	std::string		getCLInitCommand() const override;
+	ci::fs::path	getCLInitPath() const override;
+	ci::fs::path	getCompilerPath() const override;
+	std::string		getCompilerInitArgs() const override;
+
+	bool			mIsClang;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
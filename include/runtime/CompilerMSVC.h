@@ -21,12 +21,11 @@
 #pragma once
 
 #include "runtime/CompilerBase.h"
+#include "runtime/BuildSettings.h"
+#include "runtime/PrecompiledHeader.h"
 
 namespace runtime {
 
-using Compiler = class CompilerMsvc; // temp shortcut
-using CompilerRef = std::shared_ptr<class CompilerMsvc>; // temp shortcut
-using CompilerPtr = std::unique_ptr<class CompilerMsvc>; // temp shortcut
 using CompilerMsvcRef = std::shared_ptr<class CompilerMsvc>;
 using CompilerMsvcPtr = std::unique_ptr<class CompilerMsvc>;
 
@@ -37,137 +36,14 @@ public:
 
 	static CompilerMsvc& instance();
 	
-	//! Describes the list of Options and arguments available when building a file
-	class BuildSettings {
-	public:
-		BuildSettings();
-		BuildSettings( bool defaultSettings );
-		BuildSettings( const ci::fs::path &vcxProjPath );
+	using BuildSettings = runtime::BuildSettings;
 
-		//! Adds an extra include folder to the compiler BuildSettings
-		BuildSettings& include( const ci::fs::path &path );
-		//! Adds an extra include folder to the compiler BuildSettings
-		BuildSettings& libraryPath( const ci::fs::path &path );
-		//! Adds an extra include folder to the compiler BuildSettings
-		BuildSettings& library( const std::string &library );
-		
-		//! Adds a preprocessor definition to the compiler BuildSettings
-		BuildSettings& define( const std::string &definition );
-		
-		//! Specifies the path to the precompiled header.
-		BuildSettings& usePrecompiledHeader( bool use = true /*const ci::fs::path &path*/ );
-		//! Specifies the path to the precompiled header.
-		BuildSettings& createPrecompiledHeader( bool create = true /*const ci::fs::path &path*/ );
-		//! Adds a forced include as the first lined of the compiled file (If you use multiple /FI options, files are included in the order they are processed by CL.)
-		BuildSettings& forceInclude( const std::string &filename );
-		//! Specifies an additional file to be compiled (and linked).
-		BuildSettings& additionalSource( const ci::fs::path &cppFile );
-		//! Specifies additional files to be compiled (and linked).
-		BuildSettings& additionalSources( const std::vector<ci::fs::path> &cppFiles );
-		
-		//! Specifies an object (.obj) file name or directory to be used instead of the default.
-		BuildSettings& objectFile( const ci::fs::path &path );
-		//! Specifies a file name for the program database (PDB) file created by /Z7, /Zi, /ZI (Debug Information Format).
-		BuildSettings& programDatabase( const ci::fs::path &path );
-		
-		//! Sets the output directory path
-		BuildSettings& outputPath( const ci::fs::path &path );
-		//! Sets the intermediate directory path
-		BuildSettings& intermediatePath( const ci::fs::path &path );
-		
-		//! Specifies the build configuration (Debug_Shared, Release_Shared, Release, Debug, etc...)
-		BuildSettings& configuration( const std::string &option );
-		//! Specifies the target platform (Win32 or x64)
-		BuildSettings& platform( const std::string &option );
-		//! Specifies the target platform toolset (v120, v140, v141, etc..)
-		BuildSettings& platformToolset( const std::string &option );
-				
-		//! Specifies the name of the module (.dll). Also used for path generation.
-		BuildSettings& moduleName( const std::string &name );
-		//! Specifies the typename of something that is reloadable
-		BuildSettings& typeName( const std::string &typeName );
-
-		//! Adds an obj files to be linked
-		BuildSettings& linkObj( const ci::fs::path &path );
-		//! Adds the app's generated .obj files to be linked. Default to true
-		BuildSettings& linkAppObjs( bool link );
-		
-		//! Generates a class Factory source. Default to true
-		BuildSettings& generateFactory( bool generate );
-		
-		//! Adds an additional compiler option
-		BuildSettings& compilerOption( const std::string &option );
-		//! Adds an additional linker option
-		BuildSettings& linkerOption( const std::string &option );
-		//! Adds a user macro that will be string replaced in other settings.
-		BuildSettings& userMacro( const std::string &name, const std::string &value );
-
-		//! Enables verbose mode. Disabled by default.
-		BuildSettings& verbose( bool enabled = true );
-
-		const ci::fs::path& 	getPrecompiledHeader() const { return mPrecompiledHeader; }
-		const ci::fs::path& 	getOutputPath() const { return mOutputPath; }
-		const ci::fs::path& 	getIntermediatePath() const { return mIntermediatePath; }
-		const ci::fs::path& 	getObjectFilePath() const { return mObjectFilePath; }
-		const ci::fs::path& 	getPdbPath() const { return mPdbPath; }
-		const std::string&		getConfiguration() const { return mConfiguration; }
-		const std::string&		getPlatform() const { return mPlatform; }
-		const std::string&		getPlatformToolset() const { return mPlatformToolset; }
-		const std::string&		getModuleName() const { return mModuleName; }
-		const std::string&		getTypeName() const { return mTypeName; }
-
-		const std::vector<ci::fs::path>& 	getIncludes() const { return mIncludes; }
-		const std::vector<ci::fs::path>& 	getLibraryPaths() const { return mLibraryPaths; }
-		const std::vector<ci::fs::path>& 	getAdditionalSources() const { return mAdditionalSources; }
-		const std::vector<std::string>& 	getLibraries() const { return mLibraries; }
-		const std::vector<std::string>& 	getPpDefinitions() const { return mPpDefinitions; }
-		const std::vector<std::string>& 	getForcedIncludes() const { return mForcedIncludes; }
-		const std::vector<std::string>& 	getCompilerOptions() const { return mCompilerOptions; }
-		const std::vector<std::string>& 	getLinkerOptions() const { return mLinkerOptions; }
-		const std::vector<ci::fs::path>& 	getObjPaths() const { return mObjPaths; }
-
-		const std::map<std::string, std::string>&	getUserMacros() const	{ return mUserMacros; };
-
-		bool isVerboseEnabled() const	{ return mVerbose; }
-
-		//! Method meant for debugging purposes to write a pretty string of all settings
-		std::string printToString() const;
-
-	protected:
-		friend class CompilerMsvc;
-		bool mVerbose;
-		bool mLinkAppObjs;
-		bool mGenerateFactory;
-		bool mGeneratePch;
-		bool mUsePch;
-		ci::fs::path mPrecompiledHeader;
-		ci::fs::path mOutputPath;
-		ci::fs::path mIntermediatePath;
-		ci::fs::path mObjectFilePath;
-		ci::fs::path mPdbPath;
-		std::string	mConfiguration;
-		std::string	mPlatform;
-		std::string	mPlatformToolset;
-		std::string mModuleName;
-		std::string mTypeName;
-		std::vector<ci::fs::path> mIncludes;
-		std::vector<ci::fs::path> mLibraryPaths;
-		std::vector<ci::fs::path> mAdditionalSources;
-		std::vector<std::string> mLibraries;
-		std::vector<std::string> mPpDefinitions;
-		std::vector<std::string> mForcedIncludes;
-		std::vector<std::string> mCompilerOptions;
-		std::vector<std::string> mLinkerOptions;
-		std::vector<ci::fs::path> mObjPaths;
-		std::map<std::string, std::string>	mUserMacros;
-	};
-	
 	void build( const std::string &arguments, const std::function<void(const CompilationResult&)> &onBuildFinish = nullptr ) override;
 	void build( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::function<void(const CompilationResult&)> &onBuildFinish = nullptr );
 	void build( const std::vector<ci::fs::path> &sourcesPaths, const BuildSettings &settings, const std::function<void(const CompilationResult&)> &onBuildFinish = nullptr );
 
-	//! Returns the compiler-decorated symbol of typeName's vtable.
-	std::string	getSymbolForVTable( const std::string &typeName ) const;
+	//! Returns the extension of the modules built by this compiler
+	static std::string getModuleExtension() { return ".dll"; }
 
 	//! Method meant for debugging purposes to write a pretty string of all settings
 	std::string printToString() const;
@@ -175,21 +51,40 @@ public:
 	void debugLog( BuildSettings *settings = nullptr ) const;
 
 protected:
-	std::string generateCompilerCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, CompilationResult* result ) const;
+	//! Returns the command creating the pooled precompiled header entry, extracted from the sources in sourceDir
+	std::string generatePrecompiledHeaderCommand( const PrecompiledHeaderPool::Entry &entry, const ci::fs::path &sourceDir, const BuildSettings &settings ) const;
+	//! Finds the shared precompiled header of the module and queues its build if it is missing. Returns the name of the build to wait for, or an empty string if the module doesn't use one. pchFlags receives the flags using it, result its object and pchEntry its entry.
+	std::string queuePrecompiledHeader( const ci::fs::path &sourcePath, const BuildSettings &settings, std::string *pchFlags, CompilationResult* result, PrecompiledHeaderPool::Entry *pchEntry );
+	//! Returns the command compiling the header of entry as a header unit in its directory
+	std::string generateHeaderUnitCommand( const PrecompiledHeaderPool::Entry &entry, const BuildSettings &settings ) const;
+	//! Finds the shared header units of the module and queues the builds of the missing ones. Returns the names of the builds to wait for, empty if the module doesn't use header units. headerUnitFlags receives the flags importing them and result their objects.
+	std::vector<std::string> queueHeaderUnits( const BuildSettings &settings, std::string *headerUnitFlags, CompilationResult* result );
+	//! Returns the command compiling the single translation unit at sourcePath
+	std::string generateCompilerCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::string &pchFlags ) const;
+	//! Returns the command writing the preprocessed translation unit at sourcePath to preprocessedPath
+	std::string generatePreprocessorCommand( const ci::fs::path &sourcePath, const ci::fs::path &preprocessedPath, const BuildSettings &settings ) const;
+	//! Returns the arguments compiling the preprocessed translation unit at inputPath to outputPath, locally on a cache miss or on a build agent
+	std::string generatePreprocessedCompilerArguments( const std::string &inputPath, const std::string &outputPath, const BuildSettings &settings ) const;
 	std::string generateLinkerCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, CompilationResult* result ) const;
-	std::string generateBuildCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, CompilationResult* result ) const;
-
-	void parseProcessOutput() override;
+	//! Returns the path of the response file listing the app objects linked into the module
+	ci::fs::path getAppObjectsResponsePath( const BuildSettings &settings ) const;
+	//! Returns the jobs building the module: every translation unit in parallel once the builds called pchBuildNames are done, then the link. pchFlags use the precompiled header or the header units.
+	BuildGraph	generateBuildGraph( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::vector<std::string> &pchBuildNames, const std::string &pchFlags, CompilationResult* result ) const;
+	//! Returns the compiler flags shared by the precompiled header and the translation units
+	std::string generateCompilerFlags( const BuildSettings &settings ) const;
+
+	//! Collects the headers listed by the preprocessor and passes the other lines on
+	void		parseLine( Worker &worker, std::string_view line ) override;
+	std::string formatDiagnostic( std::string_view line ) const override;
+	std::string getBuildDescription() const override;
 
 	std::string		getCLInitCommand() const override;
 	ci::fs::path	getCLInitPath() const override;
 	ci::fs::path	getCompilerPath() const override;
 	std::string		getCompilerInitArgs() const override;
-	
-	using Build = std::tuple<CompilationResult,std::function<void(const CompilationResult&)>,std::chrono::steady_clock::time_point>;
-	using BuildMap = std::map<ci::fs::path,Build>;
-
-	BuildMap mBuilds;
+	std::string		getShellStatusVariable() const override;
+	std::string		getShellCommandSeparator() const override { return "&"; }
+	std::string		getShellFallbackCommand( const std::string &command, int status, const std::string &fallback ) const override;
 };
 
 } // namespace runtime
@@ -0,0 +1,73 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "cinder/Filesystem.h"
+#include "cinder/Signals.h"
+
+namespace runtime {
+
+//! Keeps track of the headers included by each module and of the modules including each header, and notifies the modules depending on a header when it changes
+class DependencyIndex {
+public:
+	using ChangeFn = std::function<void( const ci::fs::path& )>;
+
+	//! Returns the global DependencyIndex instance
+	static DependencyIndex& instance();
+
+	//! Replaces the headers moduleName depends on. onChange is called on the main thread with the header every time one of them changes.
+	void setDependencies( const std::string &moduleName, const std::vector<ci::fs::path> &headers, const ChangeFn &onChange );
+	//! Forgets moduleName and stops watching the headers nothing else depends on
+	void removeModule( const std::string &moduleName );
+
+	//! Returns the headers moduleName depends on
+	std::vector<ci::fs::path>	getDependencies( const std::string &moduleName ) const;
+	//! Returns the modules depending on header
+	std::vector<std::string>	getDependentModules( const ci::fs::path &header ) const;
+
+	//! Writes the headers moduleName depends on to path, one per line
+	void save( const std::string &moduleName, const ci::fs::path &path ) const;
+	//! Returns the headers listed in a file written by save(), so dependencies are known before the first build of a session
+	static std::vector<ci::fs::path> load( const ci::fs::path &path );
+
+protected:
+	struct Module {
+		std::set<ci::fs::path>	headers;
+		ChangeFn				onChange;
+	};
+
+	void onHeaderChanged( const ci::fs::path &header );
+	void releaseHeader( const ci::fs::path &header, const std::string &moduleName );
+
+	std::map<std::string,Module>						mModules;
+	std::map<ci::fs::path,std::set<std::string>>		mDependentModules;
+	std::map<ci::fs::path,ci::signals::ScopedConnection>	mWatches;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
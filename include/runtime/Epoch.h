@@ -0,0 +1,84 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+namespace runtime {
+
+//! Defers the release of old versions of modules until no thread can be running their code anymore. Threads calling into watched instances register and report quiescent points, where they don't run code from a module; the previous version of a module is only unloaded once each of them reported one after the instances moved to the new version.
+class Epoch {
+public:
+	//! Returns the global Epoch instance
+	static Epoch& instance();
+
+	//! Registers the calling thread as one calling into watched instances. It has to unregister before exiting.
+	void registerThread();
+	//! Unregisters the calling thread, the old versions don't wait for it anymore
+	void unregisterThread();
+	//! Reports that the calling thread isn't running code from a module, between two jobs for instance. Cheap enough to be called for every job, it also releases the old versions whose grace period is over.
+	void quiescentState();
+
+	//! Calls releaseFn once every registered thread reported a quiescent point or unregistered, right away if there's none. releaseFn might be called on any of the registered threads.
+	void retire( const std::function<void()> &releaseFn );
+	//! Returns the number of retired functions waiting for the registered threads
+	size_t getNumPending() const { return mNumPending; }
+
+	//! Registers the calling thread for its lifetime
+	class ScopedThread {
+	public:
+		ScopedThread() { Epoch::instance().registerThread(); }
+		~ScopedThread() { Epoch::instance().unregisterThread(); }
+	};
+
+	Epoch();
+
+protected:
+	struct ThreadState {
+		//! The epoch of the last quiescent point of the thread
+		std::atomic<uint64_t>	epoch;
+	};
+	struct Retired {
+		uint64_t				epoch;
+		std::function<void()>	releaseFn;
+	};
+
+	//! Calls the retired functions every registered thread passed
+	void reclaim();
+
+	std::atomic<uint64_t>						mEpoch;
+	std::atomic<size_t>							mNumPending;
+	std::mutex									mMutex;
+	std::vector<std::shared_ptr<ThreadState>>	mThreads;
+	std::deque<Retired>							mRetired;
+
+	//! State of the calling thread, null if it isn't registered
+	static thread_local std::shared_ptr<ThreadState>	sThreadState;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
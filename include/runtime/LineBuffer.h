@@ -0,0 +1,84 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+namespace runtime {
+
+//! Splits a byte stream into lines inside a fixed-size arena and hands them out as string_views
+class LineBuffer {
+public:
+	using LineFn = std::function<void( std::string_view )>;
+
+	//! Constructs a LineBuffer. Lines longer than arenaSize are split.
+	explicit LineBuffer( size_t arenaSize = 64 * 1024 );
+
+	//! Returns the free region at the end of the arena, fill it and call commit() with the number of bytes written
+	char*	prepare( size_t* size );
+	//! Commits size bytes written in the region returned by prepare() and calls lineFn for every complete line. Views are only valid for the duration of the call.
+	void	commit( size_t size, const LineFn &lineFn );
+	//! Copies data in the arena and calls lineFn for every complete line
+	void	append( const char* data, size_t size, const LineFn &lineFn );
+	//! Calls lineFn with the pending incomplete line if any
+	void	flush( const LineFn &lineFn );
+	//! Discards the pending incomplete line
+	void	clear();
+
+protected:
+	std::vector<char>	mArena;
+	size_t				mBegin;
+	size_t				mEnd;
+	size_t				mScanned;
+	bool				mSplitLine;
+};
+
+//! Keeps the most recent lines of a stream in a fixed-size byte ring, older lines are dropped first
+class LineHistory {
+public:
+	explicit LineHistory( size_t capacity = 64 * 1024 );
+
+	//! Appends a line to the history
+	void		push( std::string_view line );
+	//! Returns the retained lines separated by '\n'
+	std::string	getString() const;
+	//! Returns the number of bytes currently retained
+	size_t		size() const { return mSize; }
+	//! Returns the maximum number of bytes retained
+	size_t		capacity() const { return mData.size(); }
+	//! Clears the history
+	void		clear();
+
+protected:
+	void		pushBytes( const char* data, size_t size );
+
+	std::vector<char>	mData;
+	size_t				mStart;
+	size_t				mSize;
+	bool				mTruncated;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -20,9 +20,13 @@
 */
 #pragma once
 
+#include <vector>
+
 #include "cinder/Filesystem.h"
 #include "cinder/Signals.h"
 
+#include "runtime/ModuleManifest.h"
+
 namespace runtime {
 
 using ModulePtr = std::unique_ptr<class Module>;
@@ -30,32 +34,45 @@ using ModuleRef = std::shared_ptr<class Module>;
 
 class Module : public std::enable_shared_from_this<Module> {
 public:
-	//! Constructs a new Module object
+	//! Constructs a new Module object. Nothing is loaded until load() or updateHandle() is called.
 	Module( const ci::fs::path &path );
 	//! Destroys the Module object, release its handles and delete the temporary files
 	~Module();
 
-	//! Updates the module with a new handle
+	//! Updates the module with a new handle, loaded from getNextPath(). The previous version stays loaded until releasePreviousHandle() or the next update.
 	void updateHandle();
-	//! Changes the disk name of the current module to enable writing a new one 
-	void unlockHandle();
+	//! Unloads the previous version once the instances moved to the current one and every thread registered with rt::Epoch reported a quiescent point
+	void releasePreviousHandle();
+	//! Loads the current version of the module if it isn't loaded yet, the most recent one written by a previous session at first. Returns whether the module is usable.
+	bool load();
+	//! Unloads the current version once every thread registered with rt::Epoch reported a quiescent point. Its file is kept for load(), the module can't have live instances using it.
+	void unload();
+	//! Returns whether a version of the module is loaded
+	bool isLoaded() const;
+#if defined( RT_ENABLE_ORC_JIT )
+	//! Links the objects at objectPaths into the app with the ORC JIT and looks up symbols in them from now on. Returns false if they can't be linked, the current version stays in use then.
+	bool updateObjects( const std::vector<ci::fs::path> &objectPaths );
+#endif
 	
-#if defined( CINDER_MSW )
-	// Alias to Windows HINSTANCE
+	// Alias to Windows HINSTANCE or to the handle returned by dlopen
 	using Handle = void*;
-#else
-#endif
 	
 	//! Returns the current Handle to the module
 	Handle getHandle() const;
 	//! Returns the current path to the module
 	ci::fs::path getPath() const;
-	//! Returns the temporary path to the module
+	//! Returns the path the next build of the module has to be written to, "Foo.3.so" for "Foo.so" if the current version is 2. Every build is a new file so the loaded version is never overwritten.
+	ci::fs::path getNextPath() const;
+	//! Returns the path of the previous version of the module, until it is released
 	ci::fs::path getTempPath() const;
 	//! Returns whether the current Handle is valid
 	bool isValid() const;
 
 	void*	getSymbolAddress( const std::string &symbol ) const;
+	//! Returns the manifest exported by the current version of the module, looked up once when it's loaded. nullptr if the module doesn't export one.
+	const ModuleManifest*	getManifest() const { return mManifest; }
+	//! Returns the description of the class called typeName in the manifest of the module, nullptr if it isn't there
+	const ClassManifest*	getClassManifest( const std::string &typeName ) const;
 	
 	//! Returns the signal used to notify when the Module/Handle is about to be unloaded
 	ci::signals::Signal<void(const Module&)>& getCleanupSignal();
@@ -63,7 +80,17 @@ public:
 	ci::signals::Signal<void(const Module&)>& getChangedSignal();
 
 protected:
+	//! Looks up the manifest of the version of the module that has just been loaded
+	void updateManifest();
+
 	Handle			mHandle;
+	//! The previous version stays loaded until the instances moved to the current one
+	Handle			mPreviousHandle;
+	uint32_t		mVersion;
+#if defined( RT_ENABLE_ORC_JIT )
+	void*			mJitLibrary;
+#endif
+	const ModuleManifest*	mManifest;
 	ci::fs::path	mPath, mTempPath;
 	
 	ci::signals::Signal<void(const Module&)> mChangedSignal;
@@ -0,0 +1,64 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//! Version of the layout of rt::ModuleManifest, modules exporting another one are ignored
+#define RT_MODULE_MANIFEST_VERSION 2
+
+namespace runtime {
+
+//! Describes a class compiled in a module
+struct ClassManifest {
+	//! Name of the class, with its namespaces
+	const char*	typeName;
+	//! Returns the vtable pointer of the instances of the class, nullptr if it isn't polymorphic. The first call constructs and destroys an instance in scratch storage to read it.
+	const void*	(*vtable)();
+	//! Allocates and constructs a new instance
+	void*		(*newOperator)();
+	//! Constructs a new instance at address
+	void*		(*placementNewOperator)( void* address );
+	//! Destroys and frees an instance allocated by newOperator
+	void		(*deleteOperator)( void* instance );
+	size_t		size;
+	size_t		alignment;
+	//! Hash of the data members, bases, size and alignment of the class. Existing instances keep working with a new version that has the same one.
+	uint64_t	layoutHash;
+};
+
+//! Exported by the generated factory of every module as rt_module_manifest, the only symbol looked up when the module is loaded
+struct ModuleManifest {
+	uint32_t				version;
+	uint32_t				numClasses;
+	const ClassManifest*	classes;
+};
+
+//! Returns the layout hash of a class whose bases and data member declarations hash to membersHash
+constexpr uint64_t hashLayout( uint64_t membersHash, size_t size, size_t alignment )
+{
+	return ( ( ( membersHash ^ size ) * 1099511628211ull ) ^ alignment ) * 1099511628211ull;
+}
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -0,0 +1,69 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <functional>
+#include <list>
+#include <mutex>
+
+namespace runtime {
+
+class Module;
+
+//! Keeps track of the loaded modules, least recently used last, and unloads the ones whose last instance is gone. Modules with live instances are never unloaded, the idle ones stay loaded while there are less than getMaxResidentModules() loaded modules. An unloaded module keeps its watches and build artifacts and is loaded again when an instance is created.
+class ModuleResidency {
+public:
+	//! Returns the global ModuleResidency instance
+	static ModuleResidency& instance();
+
+	using IdleFn = std::function<bool()>;
+
+	//! Marks module as the most recently used one, adding it to the loaded modules. isIdle returns whether the module doesn't have live instances anymore and can be unloaded.
+	void touch( Module &module, const IdleFn &isIdle );
+	//! Unloads the least recently used idle modules until there are at most getMaxResidentModules() loaded modules, or only modules with live instances
+	void trim();
+	//! Forgets about module without unloading it
+	void remove( Module &module );
+
+	//! Sets the number of loaded modules above which the idle ones are unloaded. Defaults to 0, a module is unloaded as soon as its last instance is gone.
+	void	setMaxResidentModules( size_t maxResidentModules );
+	//! Returns the number of loaded modules above which the idle ones are unloaded
+	size_t	getMaxResidentModules() const { return mMaxResidentModules; }
+	//! Returns the number of modules currently loaded
+	size_t	getNumResidentModules() const;
+
+	ModuleResidency();
+
+protected:
+	struct Resident {
+		Module*	module;
+		IdleFn	isIdle;
+	};
+
+	size_t					mMaxResidentModules;
+	mutable std::mutex		mMutex;
+	//! Most recently used first
+	std::list<Resident>		mResidents;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -0,0 +1,59 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+class BuildGraph;
+
+//! Content-addressed store of compiled objects. Objects are keyed by a hash of the preprocessed translation unit and of the command compiling it.
+class ObjectCache {
+public:
+	explicit ObjectCache( const ci::fs::path &directory );
+
+	//! Returns the key of the translation unit preprocessed at preprocessedPath and compiled by compileCommand, or 0 if the preprocessed file can't be read
+	static uint64_t	computeKey( const ci::fs::path &preprocessedPath, const std::string &compileCommand );
+
+	//! Copies the object stored under key to objectPath. Returns false if there's none.
+	bool	fetch( uint64_t key, const ci::fs::path &objectPath ) const;
+	//! Stores a copy of the object at objectPath under key
+	void	store( uint64_t key, const ci::fs::path &objectPath ) const;
+
+	//! Adds the jobs producing objectPath to graph: preprocessCommand writing preprocessedPath, then compileCommand unless the cache already holds the object. Returns the index of the job producing the object.
+	size_t	addCompileJobs( BuildGraph *graph, const std::string &label, const std::string &preprocessCommand, const ci::fs::path &preprocessedPath, const std::string &compileCommand, const ci::fs::path &objectPath, const std::vector<size_t> &dependencies ) const;
+
+	const ci::fs::path&	getDirectory() const { return mDirectory; }
+
+protected:
+	ci::fs::path	getObjectPath( uint64_t key, const ci::fs::path &extension ) const;
+
+	ci::fs::path	mDirectory;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
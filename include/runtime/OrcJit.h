@@ -0,0 +1,64 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "cinder/Filesystem.h"
+
+namespace llvm { namespace orc { class LLJIT; } }
+
+namespace runtime {
+
+//! Links the objects of a module into the running process with LLVM's ORC JIT, instead of linking a module on disk and loading it. Only available when Runtime is built with RT_ENABLE_ORC_JIT.
+class OrcJit {
+public:
+	//! Returns the global OrcJit instance
+	static OrcJit& instance();
+	~OrcJit();
+
+	//! Links the objects at objectPaths as a new library named after name and runs their static initializers. The symbols they don't define are resolved against the app and the libraries it loaded. Returns nullptr and logs the errors if they can't be linked.
+	void*	load( const std::string &name, const std::vector<ci::fs::path> &objectPaths );
+	//! Returns the address of symbol in a library returned by load, nullptr if it doesn't define it
+	void*	getSymbolAddress( void* library, const std::string &symbol ) const;
+
+protected:
+	OrcJit();
+
+	//! A section of function pointers to call once the objects are linked, .init_array with ELF and .CRT$XC* with COFF
+	struct Initializers {
+		std::string	section;
+		uint64_t	address;
+		uint64_t	size;
+	};
+
+	std::unique_ptr<llvm::orc::LLJIT>	mJit;
+	std::map<std::string,size_t>		mVersions;
+	std::vector<Initializers>			mPendingInitializers;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "cinder/Filesystem.h"
 
 namespace runtime {
@@ -7,6 +10,46 @@ namespace runtime {
 //! Generates the object factory file with a set of extern "C" functions allowing instancing of the class
 bool generatePrecompiledHeader( const ci::fs::path &sourcePath, const ci::fs::path &outputHeader, const ci::fs::path &outputCpp, bool force );
 
+//! Returns the include lines of sourcePath and of its header that go in its precompiled header
+std::vector<std::string> getPrecompiledHeaderIncludes( const ci::fs::path &sourcePath );
+
+//! Precompiled headers shared by every module whose sources have the same includes and are compiled with the same flags
+class PrecompiledHeaderPool {
+public:
+	struct Entry {
+		//! Hash of the includes and flags naming the entry
+		std::string		key;
+		ci::fs::path	directory;
+		ci::fs::path	header;
+		ci::fs::path	source;
+	};
+
+	explicit PrecompiledHeaderPool( const ci::fs::path &directory );
+
+	//! Fills entry with the precompiled header of includes compiled with flags and writes its header and source the first time. Returns false if there's nothing to precompile.
+	bool acquire( const std::vector<std::string> &includes, const std::string &flags, Entry *entry ) const;
+	//! Fills entry with the C++20 header unit of header, a name found in the include paths, compiled with flags. Its header is that name and it has no source.
+	void acquireHeaderUnit( const std::string &header, const std::string &flags, Entry *entry ) const;
+	//! Returns the directory grouping the header units compiled with flags
+	ci::fs::path getHeaderUnitsDirectory( const std::string &flags ) const;
+	//! Returns whether outputPath, the compiled entry, exists and none of the headers it was compiled from changed since. Headers whose modification time changed are hashed again. An entry without a recorded header is never up to date.
+	bool isUpToDate( const Entry &entry, const ci::fs::path &outputPath ) const;
+	//! Records the content of the headers entry was compiled from, once its build succeeded. An empty list means the build didn't report its includes, the record is removed so the entry is built again.
+	void recordDependencies( const Entry &entry, const std::vector<ci::fs::path> &headers ) const;
+	//! Forgets the headers entry was compiled from, before building it again
+	void invalidate( const Entry &entry ) const;
+	//! Returns the headers entry was compiled from at its last successful build. Compilers don't list them when compiling a source using the entry.
+	std::vector<ci::fs::path> getDependencies( const Entry &entry ) const;
+
+	const ci::fs::path&	getDirectory() const { return mDirectory; }
+
+protected:
+	//! Returns the path of the file listing the hash and modification time of the headers the entry was compiled from
+	ci::fs::path	getDependenciesPath( const Entry &entry ) const { return entry.directory / "Pch.deps"; }
+
+	ci::fs::path	mDirectory;
+};
+
 } // namespace runtime
 
-namespace rt = runtime;
\ No newline at end of file
+namespace rt = runtime;
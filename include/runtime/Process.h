@@ -28,33 +28,53 @@
 #include <future>
 #include <ostream>
 #include <sstream>
-#include <queue>
+#include <atomic>
+#include <mutex>
+#include <functional>
+
+#include "runtime/RingBuffer.h"
 
 using ProcessPtr = std::unique_ptr<class Process>;
 using ProcessRef = std::shared_ptr<class Process>;
 
 class Process {
 public:
-	//! Constructs and initialize a new process in the current directory. Will by default redirect the content of StdOut, StdErr and StdIn.
-	Process( const std::string &cmd, bool redirectOutput = true, bool redirectError = true, bool redirectInput = true );
-	//! Constructs and initialize a new process in the specified directory. Will by default redirect the content of StdOut, StdErr and StdIn.
-	Process( const std::string &cmd, const std::string &path, bool redirectOutput = true, bool redirectError = true, bool redirectInput = true );
+	//! Constructs and initialize a new process in the current directory. Will by default redirect the content of StdOut, StdErr and StdIn. With mergeError StdErr is written to the output pipe, interleaved with StdOut, instead of being redirected separately.
+	Process( const std::string &cmd, bool redirectOutput = true, bool redirectError = true, bool redirectInput = true, bool mergeError = false );
+	//! Constructs and initialize a new process in the specified directory. Will by default redirect the content of StdOut, StdErr and StdIn. With mergeError StdErr is written to the output pipe, interleaved with StdOut, instead of being redirected separately.
+	Process( const std::string &cmd, const std::string &path, bool redirectOutput = true, bool redirectError = true, bool redirectInput = true, bool mergeError = false );
 	
 	//! Waits for the output redirection thread to finish and returns its string 
 	std::string	getOutputSync();
 	//! Waits for the error redirection thread to finish and returns its string
 	std::string	getErrorSync();
-	//! Pops and returns the first output available. Returns an empty string if no output is available.
+	//! Pops and returns all the output available. Returns an empty string if no output is available.
 	std::string	getOutputAsync();
-	//! Pops and returns the first error available. Returns an empty string if no error is available.
+	//! Pops and returns all the errors available. Returns an empty string if no error is available.
 	std::string	getErrorAsync();
+	//! Pops up to size bytes of output into data without allocating. Returns the number of bytes read.
+	size_t		readOutputAsync( char* data, size_t size );
+	//! Pops up to size bytes of error into data without allocating. Returns the number of bytes read.
+	size_t		readErrorAsync( char* data, size_t size );
 	//! Returns whether the a new output from the redirection thread is available
-	bool isOutputAvailable();
+	bool isOutputAvailable() const;
 	//! Returns whether the error from the redirection thread is available
-	bool isErrorAvailable();
+	bool isErrorAvailable() const;
+	//! Returns the number of output bytes discarded because the output ring was full
+	size_t getOutputDroppedBytes() const;
+	//! Returns the number of error bytes discarded because the error ring was full
+	size_t getErrorDroppedBytes() const;
+	//! Sets a function called on the reader thread with every chunk of output instead of queuing it for the async methods. Output queued so far is handed to it right away.
+	void setOutputHandler( const std::function<void( const char*, size_t )> &handler );
+	//! Limits what getOutputSync() and getErrorSync() return to the last maxBytes of each stream. Unlimited by default, long lived processes should set a limit.
+	void setSyncOutputLimit( size_t maxBytes );
 
-	//! Waits for the process to terminate and returns its exit code
+	//! Returns whether the process exited, even if a process it started still holds its output open
+	bool hasExited();
+	//! Waits for the process to terminate and returns its exit code. Once it exited, what it wrote is read and the pipes are closed, even if a process it started still holds them open.
 	int16_t terminate();
+	//! Forcefully stops the process and every process it started. Call terminate() afterward to reap it.
+	void kill();
 	//! Closes the input pipe and read all waiting commands
 	void closeInput();
 
@@ -62,22 +82,22 @@ public:
 	~Process();
 protected:
 	
-	//! Write to the input pipe
+	//! Write to the input pipe. Fails if the process closed it, without raising SIGPIPE.
 	bool write( const std::string &cmd );
 	template <typename T> friend inline Process& operator <<(Process& process, const T &value );
 	template <typename T> friend inline ProcessPtr& operator <<(ProcessPtr& process, const T &value );
 	friend inline Process& operator <<(Process& process, std::ostream&(*f)(std::ostream&) );
 	friend inline ProcessPtr& operator <<(ProcessPtr& process, std::ostream&(*f)(std::ostream&) );
 
+	//! Hands a chunk of output to the output handler or to the output ring
+	void pushOutput( const char* data, size_t size );
+
 	bool							mProcessRunning;
-	bool							mIsOutputQueueEmpty;
-	bool							mIsErrorQueueEmpty;
-	std::mutex						mOutputQueueMutex;
-	std::mutex						mOutputQueueEmptyMutex;
-	std::mutex						mErrorQueueMutex;
-	std::mutex						mErrorQueueEmptyMutex;
-	std::queue<std::string>			mOutputQueue;
-	std::queue<std::string>			mErrorQueue;
+	std::atomic<size_t>				mSyncOutputLimit;
+	runtime::RingBuffer				mOutputRing;
+	runtime::RingBuffer				mErrorRing;
+	std::mutex						mOutputHandlerMutex;
+	std::function<void( const char*, size_t )>	mOutputHandler;
 	std::unique_ptr<std::thread>	mOutputReadThread;
 	std::unique_ptr<std::thread>	mErrorReadThread;
 	std::future<std::string>		mOutputFuture;
@@ -88,7 +108,21 @@ protected:
 	void* mErrorRead;
 	void* mInputWrite;
 	void* mProcess;
+	void* mJob;
 #else
+	//! Called from the pipe reader thread when one of the redirected pipes reaches EOF
+	void onPipeClosed();
+	//! Reaps the child if it exited. Called from the pipe reader thread when the child exits, or once its pipes are closed if the system can't notify its exit.
+	void onExited();
+
+	int						mInputWrite;
+	int						mPid;
+	uint64_t				mOutputPipe;
+	uint64_t				mErrorPipe;
+	std::future<void>		mExitFuture;
+	std::atomic<int>		mOpenPipes;
+	std::atomic<bool>		mExited;
+	std::atomic<int>		mExitCode;
 #endif
 };
 
@@ -0,0 +1,155 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+
+namespace runtime {
+
+//! Fixed capacity single-producer / single-consumer byte ring. Lock-free, its storage is allocated by the first write so that a stream nothing is written to doesn't cost its capacity.
+class RingBuffer {
+public:
+	//! Describes what write() does when the ring is full
+	enum class OverflowPolicy {
+		//! Bytes that don't fit are discarded and accounted for in getDroppedBytes()
+		DROP_NEWEST,
+		//! The producer yields until the consumer frees enough space
+		BLOCK
+	};
+
+	//! Constructs a ring able to hold at least capacity bytes (rounded up to the next power of two)
+	explicit RingBuffer( size_t capacity = 1 << 20, OverflowPolicy policy = OverflowPolicy::DROP_NEWEST );
+
+	RingBuffer( const RingBuffer& ) = delete;
+	RingBuffer& operator=( const RingBuffer& ) = delete;
+
+	//! Producer side. Copies size bytes into the ring and returns the number of bytes actually written. The first write allocates the storage of the ring.
+	size_t write( const char* data, size_t size );
+	//! Consumer side. Copies up to size bytes out of the ring and returns the number of bytes read
+	size_t read( char* data, size_t size );
+	//! Consumer side. Returns a pointer to the next contiguous readable region and its size, the region stays valid until consume() is called
+	const char* peek( size_t* size ) const;
+	//! Consumer side. Releases size bytes previously returned by peek()
+	void consume( size_t size );
+
+	//! Returns the number of bytes available to read
+	size_t size() const { return mHead.load( std::memory_order_acquire ) - mTail.load( std::memory_order_acquire ); }
+	//! Returns whether there's nothing to read
+	bool empty() const { return size() == 0; }
+	//! Returns the total capacity of the ring
+	size_t capacity() const { return mMask + 1; }
+	//! Returns the number of bytes discarded with OverflowPolicy::DROP_NEWEST
+	size_t getDroppedBytes() const { return mDroppedBytes.load( std::memory_order_relaxed ); }
+
+protected:
+	static size_t roundUpPowerOfTwo( size_t value );
+
+	std::unique_ptr<char[]>	mData;
+	size_t					mMask;
+	OverflowPolicy			mPolicy;
+	// producer and consumer indices live on separate cache lines to avoid false sharing
+	alignas(64) std::atomic<size_t>	mHead;
+	alignas(64) std::atomic<size_t>	mTail;
+	alignas(64) std::atomic<size_t>	mDroppedBytes;
+};
+
+inline RingBuffer::RingBuffer( size_t capacity, OverflowPolicy policy )
+: mMask( roundUpPowerOfTwo( std::max<size_t>( capacity, 2 ) ) - 1 ), mPolicy( policy ), mHead( 0 ), mTail( 0 ), mDroppedBytes( 0 )
+{
+}
+
+inline size_t RingBuffer::roundUpPowerOfTwo( size_t value )
+{
+	size_t result = 1;
+	while( result < value ) result <<= 1;
+	return result;
+}
+
+inline size_t RingBuffer::write( const char* data, size_t size )
+{
+	// the consumer only reads the storage once the head published with release moved
+	if( ! mData && size ) {
+		mData.reset( new char[mMask + 1] );
+	}
+
+	size_t written = 0;
+	while( written < size ) {
+		const size_t head = mHead.load( std::memory_order_relaxed );
+		const size_t tail = mTail.load( std::memory_order_acquire );
+		const size_t available = capacity() - ( head - tail );
+		if( available == 0 ) {
+			if( mPolicy == OverflowPolicy::BLOCK ) {
+				std::this_thread::yield();
+				continue;
+			}
+			mDroppedBytes.fetch_add( size - written, std::memory_order_relaxed );
+			break;
+		}
+
+		// copy in at most two segments, the second one wrapping around the start of the buffer
+		const size_t count = std::min( available, size - written );
+		const size_t offset = head & mMask;
+		const size_t first = std::min( count, capacity() - offset );
+		std::memcpy( mData.get() + offset, data + written, first );
+		std::memcpy( mData.get(), data + written + first, count - first );
+		mHead.store( head + count, std::memory_order_release );
+		written += count;
+	}
+	return written;
+}
+
+inline size_t RingBuffer::read( char* data, size_t size )
+{
+	const size_t tail = mTail.load( std::memory_order_relaxed );
+	const size_t head = mHead.load( std::memory_order_acquire );
+	const size_t count = std::min( head - tail, size );
+	if( ! count ) {
+		return 0;
+	}
+	const size_t offset = tail & mMask;
+	const size_t first = std::min( count, capacity() - offset );
+	std::memcpy( data, mData.get() + offset, first );
+	std::memcpy( data + first, mData.get(), count - first );
+	mTail.store( tail + count, std::memory_order_release );
+	return count;
+}
+
+inline const char* RingBuffer::peek( size_t* size ) const
+{
+	const size_t tail = mTail.load( std::memory_order_relaxed );
+	const size_t head = mHead.load( std::memory_order_acquire );
+	const size_t offset = tail & mMask;
+	*size = std::min( head - tail, capacity() - offset );
+	return *size ? mData.get() + offset : nullptr;
+}
+
+inline void RingBuffer::consume( size_t size )
+{
+	mTail.store( mTail.load( std::memory_order_relaxed ) + size, std::memory_order_release );
+}
+
+} // namespace runtime
+
+namespace rt = runtime;
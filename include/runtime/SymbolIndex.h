@@ -0,0 +1,72 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+//! Keeps the symbols defined and referenced by object files (COFF and ELF), read again when an object changes, to link a module with only the objects it needs
+class SymbolIndex {
+public:
+	//! Returns the global SymbolIndex instance
+	static SymbolIndex& instance();
+
+	//! Fills closure with the candidates defining the symbols referenced by objects, and the ones referenced by those in turn. Candidates that can't be read are always part of it. Returns false if one of objects can't be read, the closure isn't known then.
+	bool getLinkClosure( const std::vector<ci::fs::path> &objects, const std::vector<ci::fs::path> &candidates, std::vector<ci::fs::path> *closure );
+
+	//! Reads the index saved at path, unless it was already loaded from there
+	void load( const ci::fs::path &path );
+	//! Writes the index to the path it was loaded from if an object was read since
+	void save();
+
+protected:
+	struct Object {
+		int64_t						writeTime;
+		uint64_t					size;
+		bool						readable;
+		//! Symbols defined once, in a regular section
+		std::vector<std::string>	defined;
+		//! Symbols that may be defined by several objects: weak symbols and COMDAT sections
+		std::vector<std::string>	weak;
+		std::vector<std::string>	undefined;
+	};
+
+	//! Returns the symbols of the object at path, read again if it changed since it was indexed
+	const Object&	getObject( const ci::fs::path &path );
+	//! Reads the symbol table of the COFF or ELF object at path. Returns false for other formats, and for MSVC /GL objects that only hold intermediate code.
+	static bool		readSymbols( const ci::fs::path &path, Object *object );
+
+	SymbolIndex();
+
+	std::map<ci::fs::path,Object>	mObjects;
+	ci::fs::path					mPath;
+	bool							mModified;
+};
+
+} // namespace runtime
+
+namespace rt = runtime;
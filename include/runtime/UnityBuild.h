@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "cinder/Filesystem.h"
+
+namespace runtime {
+
+//! Returns the translation units compiling sources in a unity build: the sources matching exclusions (by path, or by file name for bare names) alone, the others in groups of chunkSize included by the generated sources directory/<name>Unity<index>.cpp. Generated sources are only written when their content changes.
+std::vector<ci::fs::path> generateUnitySources( const std::vector<ci::fs::path> &sources, const std::vector<ci::fs::path> &exclusions, size_t chunkSize, const ci::fs::path &directory, const std::string &name );
+
+} // namespace runtime
+
+namespace rt = runtime;
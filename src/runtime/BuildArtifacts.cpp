@@ -0,0 +1,110 @@
+#include "runtime/BuildArtifacts.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+BuildArtifacts& BuildArtifacts::instance()
+{
+	static BuildArtifacts artifacts;
+	return artifacts;
+}
+
+BuildArtifacts::BuildArtifacts()
+: mMaxDiskUsage( 1024 * 1024 * 1024 )
+{
+}
+
+ci::fs::path BuildArtifacts::getNextName( const ci::fs::path &path )
+{
+	auto parent = path.parent_path();
+	auto stem = path.stem().string();
+	auto ext = path.extension().string();
+
+	lock_guard<mutex> lock( mMutex );
+	auto it = mCounters.find( path );
+	if( it == mCounters.end() ) {
+		// the names left by a previous session, "Foo_<n>.pdb"
+		uint32_t next = 0;
+		auto prefix = stem + "_";
+		std::error_code errorCode;
+		for( fs::directory_iterator entry( parent, errorCode ), end; ! errorCode && entry != end; entry.increment( errorCode ) ) {
+			auto entryStem = entry->path().stem().string();
+			if( entry->path().extension() == ext && entryStem.size() > prefix.size() && entryStem.compare( 0, prefix.size(), prefix ) == 0
+				&& entryStem.find_first_not_of( "0123456789", prefix.size() ) == string::npos ) {
+				next = std::max( next, static_cast<uint32_t>( std::stoul( entryStem.substr( prefix.size() ) ) ) + 1 );
+			}
+		}
+		it = mCounters.emplace( path, next ).first;
+	}
+	return parent / ( stem + "_" + to_string( it->second++ ) + ext );
+}
+
+void BuildArtifacts::collect( const ci::fs::path &directory, const std::vector<ci::fs::path> &keep )
+{
+	auto isKept = [&keep]( const fs::path &file ) {
+		return std::any_of( keep.begin(), keep.end(), [&file]( const fs::path &kept ) {
+			return kept.stem() == file.stem() && kept.parent_path().lexically_normal() == file.parent_path().lexically_normal();
+		} );
+	};
+
+	std::vector<fs::path> unused;
+	std::error_code errorCode;
+	for( fs::directory_iterator entry( directory, errorCode ), end; ! errorCode && entry != end; entry.increment( errorCode ) ) {
+		if( entry->is_regular_file( errorCode ) && ! isKept( entry->path() ) ) {
+			unused.push_back( entry->path() );
+		}
+	}
+
+	// a loaded version or a pdb opened by the debugger can't be deleted on Windows, the next collection tries again
+	for( const auto &file : unused ) {
+		fs::remove( file, errorCode );
+	}
+}
+
+void BuildArtifacts::trim( const ci::fs::path &directory, const ci::fs::path &cacheDirectory )
+{
+	if( ! mMaxDiskUsage ) {
+		return;
+	}
+
+	struct CachedFile {
+		fs::path				path;
+		uintmax_t				size;
+		fs::file_time_type		lastUse;
+	};
+
+	uintmax_t usage = 0;
+	std::vector<CachedFile> cachedFiles;
+	std::error_code errorCode;
+	for( fs::recursive_directory_iterator entry( directory, errorCode ), end; ! errorCode && entry != end; entry.increment( errorCode ) ) {
+		if( ! entry->is_regular_file( errorCode ) ) {
+			continue;
+		}
+		auto size = entry->file_size( errorCode );
+		usage += errorCode ? 0 : size;
+		// objects being stored are written to a temporary file first
+		if( entry->path().parent_path().lexically_normal() == cacheDirectory.lexically_normal() && entry->path().extension() != ".tmp" ) {
+			cachedFiles.push_back( { entry->path(), size, entry->last_write_time( errorCode ) } );
+		}
+	}
+	if( usage <= mMaxDiskUsage ) {
+		return;
+	}
+
+	// the cache refreshes the time of the objects it hands out, the oldest are the least recently used
+	std::sort( cachedFiles.begin(), cachedFiles.end(), []( const CachedFile &a, const CachedFile &b ) { return a.lastUse < b.lastUse; } );
+	for( const auto &file : cachedFiles ) {
+		if( usage <= mMaxDiskUsage ) {
+			break;
+		}
+		if( fs::remove( file.path, errorCode ) ) {
+			usage -= std::min( usage, file.size );
+		}
+	}
+}
+
+} // namespace runtime
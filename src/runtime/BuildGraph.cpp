@@ -0,0 +1,141 @@
+#include "runtime/BuildGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace runtime {
+
+BuildGraph::BuildGraph()
+: mNumRunning( 0 ), mNumSucceeded( 0 ), mFailed( false )
+{
+}
+
+size_t BuildGraph::addJob( const std::string &label, const std::string &command, const std::vector<size_t> &dependencies )
+{
+	// depending only on existing jobs keeps the graph acyclic
+	for( auto dependency : dependencies ) {
+		if( dependency >= mJobs.size() ) {
+			throw std::out_of_range( "BuildGraph: job " + label + " depends on a job that doesn't exist yet" );
+		}
+	}
+	mJobs.push_back( { label, command, dependencies, State::WAITING, false, nullptr, nullptr, nullptr, {} } );
+	return mJobs.size() - 1;
+}
+
+size_t BuildGraph::addExternalJob( const std::string &name )
+{
+	mJobs.push_back( { name, "", {}, State::WAITING, true, nullptr, nullptr, nullptr, {} } );
+	return mJobs.size() - 1;
+}
+
+bool BuildGraph::resolveExternalJobs( const std::string &name, bool succeeded )
+{
+	bool resolved = false;
+	for( auto &job : mJobs ) {
+		if( job.external && job.state == State::WAITING && job.label == name ) {
+			job.state = succeeded ? State::SUCCEEDED : State::FAILED;
+			if( succeeded ) {
+				++mNumSucceeded;
+			}
+			else {
+				mFailed = true;
+			}
+			resolved = true;
+		}
+	}
+	return resolved;
+}
+
+std::vector<std::string> BuildGraph::getPendingExternalJobs() const
+{
+	std::vector<std::string> names;
+	for( const auto &job : mJobs ) {
+		if( job.external && job.state == State::WAITING ) {
+			names.push_back( job.label );
+		}
+	}
+	return names;
+}
+
+std::vector<size_t> BuildGraph::startReadyJobs( std::vector<size_t> *checkedJobs )
+{
+	std::vector<size_t> readyJobs;
+	if( mFailed ) {
+		return readyJobs;
+	}
+	// dependencies come first, skipping a job in this pass can make the following ones ready
+	for( size_t i = 0; i < mJobs.size(); ++i ) {
+		if( mJobs[i].state == State::WAITING && ! mJobs[i].external && std::all_of( mJobs[i].dependencies.begin(), mJobs[i].dependencies.end(), [this]( size_t dependency ) { return mJobs[dependency].state == State::SUCCEEDED; } ) ) {
+			if( mJobs[i].isUpToDate && checkedJobs ) {
+				// counted as running until the check finishes so the graph doesn't finish before
+				mJobs[i].state = State::CHECKING;
+				++mNumRunning;
+				checkedJobs->push_back( i );
+			}
+			else if( mJobs[i].isUpToDate && mJobs[i].isUpToDate() ) {
+				mJobs[i].state = State::SUCCEEDED;
+				++mNumSucceeded;
+			}
+			else {
+				mJobs[i].state = State::STARTED;
+				if( mJobs[i].onStart ) {
+					mJobs[i].onStart();
+				}
+				readyJobs.push_back( i );
+			}
+		}
+	}
+	mNumRunning += readyJobs.size();
+	return readyJobs;
+}
+
+bool BuildGraph::finishCheck( size_t job, bool upToDate )
+{
+	if( job >= mJobs.size() || mJobs[job].state != State::CHECKING ) {
+		return false;
+	}
+	if( upToDate ) {
+		mJobs[job].state = State::SUCCEEDED;
+		--mNumRunning;
+		++mNumSucceeded;
+		return false;
+	}
+	// nothing starts after a failure
+	if( mFailed ) {
+		mJobs[job].state = State::WAITING;
+		--mNumRunning;
+		return false;
+	}
+	mJobs[job].state = State::STARTED;
+	if( mJobs[job].onStart ) {
+		mJobs[job].onStart();
+	}
+	return true;
+}
+
+void BuildGraph::finishJob( size_t job, bool succeeded )
+{
+	if( job >= mJobs.size() || mJobs[job].state != State::STARTED ) {
+		return;
+	}
+	mJobs[job].state = succeeded ? State::SUCCEEDED : State::FAILED;
+	--mNumRunning;
+	if( succeeded ) {
+		++mNumSucceeded;
+		if( mJobs[job].onSuccess ) {
+			mJobs[job].onSuccess();
+		}
+	}
+	else {
+		mFailed = true;
+	}
+}
+
+bool BuildGraph::isFinished() const
+{
+	return mNumRunning == 0 && ( mFailed || mNumSucceeded == mJobs.size() );
+}
+
+} // namespace runtime
@@ -0,0 +1,262 @@
+#include "runtime/BuildSettings.h"
+
+#include <sstream>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+std::string BuildSettings::printToString() const
+{
+	stringstream str;
+
+	str << "link app objs: " << mLinkAppObjs << ", link host exports: " << mLinkHostExports << ", generate factory: " << mGenerateFactory << ", generate pch: " << mGeneratePch << ", use pch: " << mUsePch << ", object cache: " << mUseObjectCache << ", symbol index: " << mUseSymbolIndex << ", orc jit: " << mUseOrcJit << "\n";
+	str << "precompiled header: " << mPrecompiledHeader << "\n";
+	str << "output path: " << mOutputPath << "\n";
+	str << "intermediate path: " << mIntermediatePath << "\n";
+	str << "pdb path: " << mPdbPath << "\n";
+	str << "host import library: " << mHostImportLibrary << "\n";
+	str << "module name: " << mModuleName << "\n";
+	str << "type name: " << mTypeName << "\n";
+	str << "includes:\n";
+	for( const auto &include : mIncludes ) {
+		str << "\t- " << include << "\n";
+	}
+	str << "library paths:\n";
+	for( const auto &path : mLibraryPaths ) {
+		str << "\t- " << path << "\n";
+	}
+	str << "libraries:\n";
+	for( const auto &lib : mLibraries ) {
+		str << "\t- " << lib << "\n";
+	}
+	str << "unity build: " << mUnitySize << "\n";
+	str << "unity exclusions:\n";
+	for( const auto &src : mUnityExclusions ) {
+		str << "\t- " << src << "\n";
+	}
+	str << "header units:\n";
+	for( const auto &header : mHeaderUnits ) {
+		str << "\t- " << header << "\n";
+	}
+	str << "additional sources:\n";
+	for( const auto &src : mAdditionalSources ) {
+		str << "\t- " << src << "\n";
+	}
+	str << "forced includes:\n";
+	for( const auto &include : mForcedIncludes ) {
+		str << "\t- " << include << "\n";
+	}
+	str << "preprocessor definitions: ";
+	for( const auto &ppDefine : mPpDefinitions ) {
+		str << ppDefine << " ";
+	}
+	str << endl;
+	str << "compiler options: ";
+	for( const auto &flag : mCompilerOptions ) {
+		str << flag << " ";
+	}
+	str << endl;
+	str << "linker options: ";
+	for( const auto &flag : mLinkerOptions ) {
+		str << flag << " ";
+	}
+	str << endl;
+	str << "user macros:\n";
+	for( const auto &macro : mUserMacros ) {
+		str << "\t- " << macro.first << " = " << macro.second << "\n";
+	}
+	str << endl;
+
+	return str.str();
+}
+
+BuildSettings& BuildSettings::include( const ci::fs::path &path )
+{
+	mIncludes.push_back( path );
+	return *this;
+}
+BuildSettings& BuildSettings::libraryPath( const ci::fs::path &path )
+{
+	mLibraryPaths.push_back( path );
+	return *this;
+}
+BuildSettings& BuildSettings::library( const std::string &library )
+{
+	mLibraries.push_back( library );
+	return *this;
+}
+BuildSettings& BuildSettings::define( const std::string &definition )
+{
+	mPpDefinitions.push_back( definition );
+	return *this;
+}
+
+BuildSettings& BuildSettings::usePrecompiledHeader( bool use /*const ci::fs::path &path*/ )
+{
+	mUsePch = use;
+	//mPrecompiledHeader = path;
+	return *this;
+}
+		
+BuildSettings& BuildSettings::createPrecompiledHeader( bool create /*const ci::fs::path &path*/ )
+{
+	mGeneratePch = create;
+	//mPrecompiledHeader = path;
+	return *this;
+}
+
+BuildSettings& BuildSettings::objectFile( const ci::fs::path &path )
+{
+	mObjectFilePath = path;
+	return *this;
+}
+BuildSettings& BuildSettings::programDatabase( const ci::fs::path &path )
+{
+	mPdbPath = path;
+	return *this;
+}
+
+BuildSettings& BuildSettings::compilerOption( const std::string &option )
+{
+	mCompilerOptions.push_back( option );
+	return *this;
+}
+BuildSettings& BuildSettings::linkerOption( const std::string &option )
+{
+	mLinkerOptions.push_back( option );
+	return *this;
+}
+BuildSettings& BuildSettings::userMacro( const std::string &name, const std::string &value )
+{
+	mUserMacros[name] = value;
+	return *this;
+}
+
+BuildSettings& BuildSettings::verbose( bool enabled )
+{
+	mVerbose = enabled;
+	return *this;
+}
+BuildSettings& BuildSettings::outputPath( const ci::fs::path &path )
+{
+	mOutputPath = path;
+	return *this;
+}
+BuildSettings& BuildSettings::intermediatePath( const ci::fs::path &path )
+{
+	mIntermediatePath = path;
+	return *this;
+}
+BuildSettings& BuildSettings::configuration( const std::string &option )
+{
+	mConfiguration = option;
+	return *this;
+}
+BuildSettings& BuildSettings::platform( const std::string &option )
+{
+	mPlatform = option;
+	return *this;
+}
+BuildSettings& BuildSettings::platformToolset( const std::string &option )
+{
+	mPlatformToolset = option;
+	return *this;
+}
+BuildSettings& BuildSettings::moduleName( const std::string &name )
+{
+	mModuleName = name;
+	return *this;
+}
+BuildSettings& BuildSettings::typeName( const std::string &typeName )
+{ 
+	mTypeName = typeName;
+	return *this;
+}
+
+BuildSettings& BuildSettings::forceInclude( const std::string &filename )
+{
+	mForcedIncludes.push_back( filename );
+	return *this;
+}
+
+BuildSettings& BuildSettings::additionalSource( const ci::fs::path &cppFile )
+{
+	mAdditionalSources.push_back( cppFile );
+	return *this;
+}
+BuildSettings& BuildSettings::additionalSources( const std::vector<ci::fs::path> &cppFiles )
+{
+	mAdditionalSources.insert( mAdditionalSources.begin(), cppFiles.begin(), cppFiles.end() );
+	return *this;
+}
+BuildSettings& BuildSettings::unityBuild( size_t sourcesPerUnit )
+{
+	mUnitySize = sourcesPerUnit;
+	return *this;
+}
+BuildSettings& BuildSettings::unityExclude( const ci::fs::path &cppFile )
+{
+	mUnityExclusions.push_back( cppFile );
+	return *this;
+}
+BuildSettings& BuildSettings::headerUnit( const std::string &header )
+{
+	mHeaderUnits.push_back( header );
+	return *this;
+}
+
+BuildSettings& BuildSettings::linkObj( const ci::fs::path &path )
+{
+	mObjPaths.push_back( path );
+	return *this;
+}
+BuildSettings& BuildSettings::linkAppObjs( bool link )
+{
+	mLinkAppObjs = link;
+	return *this;
+}
+BuildSettings& BuildSettings::linkHostExports( bool link )
+{
+	mLinkHostExports = link;
+	return *this;
+}
+BuildSettings& BuildSettings::hostImportLibrary( const ci::fs::path &path )
+{
+	mHostImportLibrary = path;
+	return *this;
+}
+
+BuildSettings& BuildSettings::objectCache( bool enabled )
+{
+	mUseObjectCache = enabled;
+	return *this;
+}
+BuildSettings& BuildSettings::symbolIndex( bool enabled )
+{
+	mUseSymbolIndex = enabled;
+	return *this;
+}
+BuildSettings& BuildSettings::orcJit( bool enabled )
+{
+	mUseOrcJit = enabled;
+	return *this;
+}
+
+bool BuildSettings::isOrcJitEnabled() const
+{
+#if defined( RT_ENABLE_ORC_JIT )
+	return mUseOrcJit;
+#else
+	return false;
+#endif
+}
+
+BuildSettings& BuildSettings::generateFactory( bool generate )
+{
+	mGenerateFactory = generate;
+	return *this;
+}
+
+} // namespace runtime
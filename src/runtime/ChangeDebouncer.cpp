@@ -0,0 +1,96 @@
+#include "runtime/ChangeDebouncer.h"
+
+#include "cinder/app/App.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+ChangeDebouncer& ChangeDebouncer::instance()
+{
+	static ChangeDebouncer debouncer;
+	return debouncer;
+}
+
+ChangeDebouncer::ChangeDebouncer()
+	: mQuietWindow( 100 ), mStop( false )
+{
+}
+
+ChangeDebouncer::~ChangeDebouncer()
+{
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mStop = true;
+	}
+	mCondition.notify_one();
+	if( mThread && mThread->joinable() ) {
+		mThread->join();
+	}
+}
+
+void ChangeDebouncer::push( const std::string &key, const ci::fs::path &file, const FlushFn &flushFn )
+{
+	if( mQuietWindow.count() <= 0 ) {
+		flushFn( { file } );
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		auto &changes = mChanges[key];
+		if( std::find( changes.files.begin(), changes.files.end(), file ) == changes.files.end() ) {
+			changes.files.push_back( file );
+		}
+		changes.flushFn = flushFn;
+		// every new change pushes the deadline back
+		changes.deadline = std::chrono::steady_clock::now() + mQuietWindow;
+
+		if( ! mThread ) {
+			mThread = make_unique<std::thread>( &ChangeDebouncer::timerThread, this );
+		}
+	}
+	mCondition.notify_one();
+}
+
+void ChangeDebouncer::timerThread()
+{
+	std::unique_lock<std::mutex> lock( mMutex );
+	while( ! mStop ) {
+		if( mChanges.empty() ) {
+			mCondition.wait( lock );
+			continue;
+		}
+
+		// sleep until the earliest deadline or until a change moves it
+		auto now = std::chrono::steady_clock::now();
+		auto deadline = std::chrono::steady_clock::time_point::max();
+		for( const auto &changes : mChanges ) {
+			deadline = std::min( deadline, changes.second.deadline );
+		}
+		if( deadline > now ) {
+			mCondition.wait_until( lock, deadline );
+			continue;
+		}
+
+		// hand the modules that have been quiet long enough to the main thread
+		for( auto it = mChanges.begin(); it != mChanges.end(); ) {
+			if( it->second.deadline <= now ) {
+				auto files = std::move( it->second.files );
+				auto flushFn = std::move( it->second.flushFn );
+				if( auto app = app::App::get() ) {
+					app->dispatchAsync( [files, flushFn]() { flushFn( files ); } );
+				}
+				it = mChanges.erase( it );
+			}
+			else {
+				++it;
+			}
+		}
+	}
+}
+
+} // namespace runtime
@@ -1,25 +1,251 @@
 #include "runtime/ClassFactory.h"
+#include <algorithm>
+#include <cctype>
 #include <fstream>
+#include <iomanip>
+#include <regex>
+#include <sstream>
+#include <vector>
 
 using namespace std;
 using namespace ci;
 
 namespace runtime {
 
-void generateClassFactory( const ci::fs::path &outputPath, const std::string &className, const std::string &headerName )
+namespace {
+
+//! 64-bit FNV-1a of str
+uint64_t hashString( const std::string &str )
+{
+	uint64_t hash = 14695981039346656037ull;
+	for( char c : str ) {
+		hash = ( hash ^ static_cast<unsigned char>( c ) ) * 1099511628211ull;
+	}
+	return hash;
+}
+
+bool isIdentifierChar( char c )
+{
+	return std::isalnum( static_cast<unsigned char>( c ) ) || c == '_';
+}
+
+//! Removes the comments and preprocessor lines of source and empties its string and character literals, so that none of them can change a declaration or hide a brace
+std::string stripSource( const std::string &source )
+{
+	std::string stripped;
+	bool lineStart = true;
+	for( size_t i = 0; i < source.size(); ++i ) {
+		char c = source[i];
+		if( c == '/' && i + 1 < source.size() && source[i + 1] == '/' ) {
+			i = std::min( source.find( '\n', i ), source.size() ) - 1;
+		}
+		else if( c == '/' && i + 1 < source.size() && source[i + 1] == '*' ) {
+			i = std::min( source.find( "*/", i + 2 ), source.size() - 2 ) + 1;
+			stripped += ' ';
+		}
+		else if( c == '#' && lineStart ) {
+			// directives continue on the next line after a backslash
+			while( i < source.size() && ( source[i] != '\n' || source[i - 1] == '\\' ) ) {
+				++i;
+			}
+			--i;
+		}
+		else if( c == '"' || c == '\'' ) {
+			for( ++i; i < source.size() && source[i] != c; ++i ) {
+				i += source[i] == '\\' ? 1 : 0;
+			}
+			stripped += std::string( 2, c );
+		}
+		else {
+			stripped += c;
+			lineStart = c == '\n' || ( lineStart && std::isspace( static_cast<unsigned char>( c ) ) );
+		}
+	}
+	return stripped;
+}
+
+//! Collapses whitespace, only keeping the spaces separating two identifiers
+std::string normalizeDeclaration( const std::string &declaration )
+{
+	std::string normalized;
+	bool space = false;
+	for( char c : declaration ) {
+		if( std::isspace( static_cast<unsigned char>( c ) ) ) {
+			space = true;
+			continue;
+		}
+		if( space && ! normalized.empty() && isIdentifierChar( normalized.back() ) && isIdentifierChar( c ) ) {
+			normalized += ' ';
+		}
+		normalized += c;
+		space = false;
+	}
+	return normalized;
+}
+
+//! Returns statement normalized if it declares a data member, an empty string for functions, types, aliases, friends and static members
+std::string getDataMember( std::string statement )
 {
-	std::ofstream outputFile( outputPath );		
-	outputFile << "#include \"" << ( headerName.empty() ? className + ".h" : headerName ) << "\"" << endl << endl;
-	outputFile << "extern \"C\" __declspec(dllexport) " << className << "* __cdecl rt_new_operator()" << endl;
-	outputFile << "{" << endl;
-	outputFile << "\treturn new " << className << "();" << endl;
-	outputFile << "}" << endl;
-	outputFile << endl;
-	outputFile << "extern \"C\" __declspec(dllexport) " << className << "* __cdecl rt_placement_new_operator(  " << className << "* address )" << endl;
-	outputFile << "{" << endl;
-	outputFile << "\treturn new (address)" << className << "();" << endl;
-	outputFile << "}" << endl;
-	outputFile << endl;
+	// access labels end up in front of the statement following them
+	static const std::regex accessLabel( "\\b(public|protected|private)\\s*:(?!:)" );
+	statement = normalizeDeclaration( std::regex_replace( statement, accessLabel, " " ) );
+
+	std::vector<std::string> tokens;
+	for( size_t i = 0; i < statement.size(); ) {
+		size_t length = 0;
+		while( i + length < statement.size() && isIdentifierChar( statement[i + length] ) ) {
+			++length;
+		}
+		if( length ) {
+			tokens.push_back( statement.substr( i, length ) );
+		}
+		i += std::max<size_t>( length, 1 );
+	}
+	for( const auto &token : tokens ) {
+		if( token == "typedef" || token == "using" || token == "friend" || token == "static" || token == "template" || token == "enum" || token == "operator" ) {
+			return std::string();
+		}
+	}
+	// "class Foo;" declares a type, "class Foo* mFoo;" a member
+	if( tokens.size() <= 2 && ! tokens.empty() && ( tokens[0] == "class" || tokens[0] == "struct" || tokens[0] == "union" ) && statement.find_first_of( "*&[" ) == std::string::npos ) {
+		return std::string();
+	}
+
+	// the default value doesn't change the layout. A parenthesis outside of template arguments is a function, unless it surrounds the name of a function pointer
+	int angleDepth = 0;
+	bool functionPointer = false;
+	for( size_t i = 0; i < statement.size(); ++i ) {
+		char c = statement[i];
+		angleDepth += c == '<' ? 1 : c == '>' ? -1 : 0;
+		if( angleDepth > 0 ) {
+			continue;
+		}
+		if( c == '=' ) {
+			return statement.substr( 0, i );
+		}
+		if( c == '(' && ! functionPointer ) {
+			auto inner = statement.substr( i + 1, statement.find( ')', i ) - i - 1 );
+			functionPointer = ! inner.empty() && ( inner[0] == '*' || inner[0] == '&' || inner.find( "::*" ) != std::string::npos );
+			if( ! functionPointer ) {
+				return std::string();
+			}
+		}
+	}
+	return statement;
+}
+
+//! Returns a hash of the bases and data member declarations of the class called className in the header at path. Comments and functions don't change it. Falls back to a hash of the whole header if the class definition isn't found, 0 if the header can't be read.
+uint64_t hashMembers( const ci::fs::path &path, const std::string &className )
+{
+	std::ifstream file( path, std::ios::binary );
+	if( ! file ) {
+		return 0;
+	}
+	std::ostringstream content;
+	content << file.rdbuf();
+	auto source = stripSource( content.str() );
+
+	// the name is looked up without its namespaces, export macros can sit between the keyword and the name
+	auto name = className.substr( className.rfind( ':' ) == std::string::npos ? 0 : className.rfind( ':' ) + 1 );
+	std::regex definition( "\\b(class|struct)\\s+(\\w+\\s+)*" + name + "\\b([^;{]*)\\{" );
+	std::smatch match;
+	if( ! std::regex_search( source, match, definition ) ) {
+		return hashString( content.str() );
+	}
+
+	std::string declarations = normalizeDeclaration( match[3].str() ) + "\n";
+	std::string statement;
+	for( size_t i = match.position( 0 ) + match.length( 0 ); i < source.size() && source[i] != '}'; ++i ) {
+		char c = source[i];
+		if( c == '{' ) {
+			// function bodies end their statement, brace initializers and nested types don't
+			for( int depth = 1; depth > 0 && ++i < source.size(); ) {
+				depth += source[i] == '{' ? 1 : source[i] == '}' ? -1 : 0;
+			}
+			if( getDataMember( statement ).empty() ) {
+				statement.clear();
+			}
+		}
+		else if( c == ';' ) {
+			auto member = getDataMember( statement );
+			if( ! member.empty() ) {
+				declarations += member + "\n";
+			}
+			statement.clear();
+		}
+		else {
+			statement += c;
+		}
+	}
+	return hashString( declarations );
+}
+
+} // anonymous namespace
+
+void generateClassFactory( const ci::fs::path &outputPath, const std::string &className, const ci::fs::path &headerPath )
+{
+	std::ostringstream output;
+	output << "#include \"" << headerPath.filename().string() << "\"" << endl;
+	output << "#include \"runtime/ModuleManifest.h\"" << endl << endl;
+	output << "#include <new>" << endl;
+	output << "#include <type_traits>" << endl << endl;
+	output << "#if defined( _MSC_VER )" << endl;
+	output << "#define RT_FACTORY_EXPORT extern \"C\" __declspec(dllexport)" << endl;
+	output << "#else" << endl;
+	output << "#define RT_FACTORY_EXPORT extern \"C\" __attribute__((visibility(\"default\")))" << endl;
+	output << "#endif" << endl << endl;
+	output << "namespace {" << endl << endl;
+	output << "using rt_class = " << className << ";" << endl << endl;
+	output << "void* rt_new_operator()" << endl;
+	output << "{" << endl;
+	output << "\treturn new rt_class();" << endl;
+	output << "}" << endl << endl;
+	output << "void* rt_placement_new_operator( void* address )" << endl;
+	output << "{" << endl;
+	output << "\treturn new (address) rt_class();" << endl;
+	output << "}" << endl << endl;
+	output << "void rt_delete_operator( void* instance )" << endl;
+	output << "{" << endl;
+	output << "\tdelete static_cast<rt_class*>( instance );" << endl;
+	output << "}" << endl << endl;
+	// the vtable pointer is whatever the constructor stores in an instance, whatever the compiler calls the vtable
+	output << "const void* rt_vtable()" << endl;
+	output << "{" << endl;
+	output << "\tif( ! std::is_polymorphic<rt_class>::value ) {" << endl;
+	output << "\t\treturn nullptr;" << endl;
+	output << "\t}" << endl;
+	output << "\tstatic const void* vtable = []() {" << endl;
+	output << "\t\talignas( rt_class ) static unsigned char storage[sizeof( rt_class )];" << endl;
+	output << "\t\tauto instance = new (storage) rt_class();" << endl;
+	output << "\t\tconst void* vtablePointer = *reinterpret_cast<const void* const*>( instance );" << endl;
+	output << "\t\tinstance->~rt_class();" << endl;
+	output << "\t\treturn vtablePointer;" << endl;
+	output << "\t}();" << endl;
+	output << "\treturn vtable;" << endl;
+	output << "}" << endl << endl;
+	output << "const rt::ClassManifest rt_classes[] = { {" << endl;
+	output << "\t\"" << className << "\"," << endl;
+	output << "\t&rt_vtable," << endl;
+	output << "\t&rt_new_operator," << endl;
+	output << "\t&rt_placement_new_operator," << endl;
+	output << "\t&rt_delete_operator," << endl;
+	output << "\tsizeof( rt_class )," << endl;
+	output << "\talignof( rt_class )," << endl;
+	// editing a comment or a function leaves the hash alone, a new or changed data member or base doesn't
+	output << "\trt::hashLayout( 0x" << std::hex << std::setfill( '0' ) << std::setw( 16 ) << hashMembers( headerPath, className ) << std::dec << "ull, sizeof( rt_class ), alignof( rt_class ) )" << endl;
+	output << "} };" << endl << endl;
+	output << "} // anonymous namespace" << endl << endl;
+	output << "RT_FACTORY_EXPORT const rt::ModuleManifest rt_module_manifest = { RT_MODULE_MANIFEST_VERSION, 1, rt_classes };" << endl;
+
+	// rewriting the same content would only compile it again
+	std::ifstream inputFile( outputPath, std::ios::binary );
+	std::ostringstream current;
+	current << inputFile.rdbuf();
+	if( ! inputFile || current.str() != output.str() ) {
+		inputFile.close();
+		std::ofstream outputFile( outputPath, std::ios::binary );
+		outputFile << output.str();
+	}
 }
 
 }
\ No newline at end of file
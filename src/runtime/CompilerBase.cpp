@@ -4,64 +4,677 @@
 #include "cinder/app/App.h"
 #include "cinder/Filesystem.h"
 
+#include <thread>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
 using namespace std;
 using namespace ci;
 
 namespace runtime {
 
 namespace {
-	inline std::string removeEndline( const std::string &input ) 
-	{ 
-		auto output = input;
-		while( output.size() && ( output.back() == '\n' ) ) output = output.substr( 0, output.length() - 1 );
-		return output;
-	}
-	inline std::string removeCarriageReturn( const std::string &input ) 
-	{ 
-		auto output = input;
-		while( output.size() && ( output.back() == '\r' ) ) output = output.substr( 0, output.length() - 1 );
-		return output;
-	}
 	inline std::string quote( const std::string &input ) { return "\"" + input + "\""; };
-}
+
+	const std::string_view sBuildMarkerPrefix = "@rt ";
+	const std::string_view sServerReadyMarker = "@rt ready";
+	const std::string_view sServerExitedMarker = "@rt exited";
+	const std::string_view sAgentUnavailableMarker = "@rt agent unavailable ";
+	//! Exit code of the build agent client when the agent can't be reached
+	const int sAgentUnavailableStatus = 75;
+
+	//! Reads a decimal number at the start of str and removes it
+	bool consumeNumber( std::string_view &str, int *number )
+	{
+		bool negative = ! str.empty() && str.front() == '-';
+		if( negative ) str.remove_prefix( 1 );
+		if( str.empty() || str.front() < '0' || str.front() > '9' ) return false;
+		int value = 0;
+		while( ! str.empty() && str.front() >= '0' && str.front() <= '9' ) {
+			value = value * 10 + ( str.front() - '0' );
+			str.remove_prefix( 1 );
+		}
+		*number = negative ? -value : value;
+		return true;
+	}
+
+	//! Parses "@rt <begin|end> <length> <name>[ <status>]"
+	bool parseBuildMarker( std::string_view line, bool *begin, std::string_view *name, int *status )
+	{
+		if( line.substr( 0, sBuildMarkerPrefix.size() ) != sBuildMarkerPrefix ) {
+			return false;
+		}
+		line.remove_prefix( sBuildMarkerPrefix.size() );
+		
+		if( line.substr( 0, 6 ) == "begin " ) {
+			*begin = true;
+			line.remove_prefix( 6 );
+		}
+		else if( line.substr( 0, 4 ) == "end " ) {
+			*begin = false;
+			line.remove_prefix( 4 );
+		}
+		else {
+			return false;
+		}
+
+		// the name is length-prefixed so it can contain anything
+		int length;
+		if( ! consumeNumber( line, &length ) || line.empty() || line.front() != ' ' || length < 0 || line.size() < static_cast<size_t>( length ) + 1 ) {
+			return false;
+		}
+		*name = line.substr( 1, length );
+		line.remove_prefix( length + 1 );
+		
+		*status = 0;
+		if( ! line.empty() && line.front() == ' ' ) {
+			line.remove_prefix( 1 );
+			consumeNumber( line, status );
+		}
+		return true;
+	}
+} // anonymous namespace
 
 CompilerBase::CompilerBase()
-	: mVerbose( false )
+	: mNumWorkers( std::max<size_t>( 1, std::thread::hardware_concurrency() / 2 ) ), mNextWorkerId( 0 ), mNextBuildId( 1 ), mVerbose( false ), mStopChecks( false )
 {
 }
 
 CompilerBase::~CompilerBase()
 {
+	{
+		std::lock_guard<std::mutex> lock( mCheckMutex );
+		mStopChecks = true;
+	}
+	mCheckCondition.notify_all();
+	for( auto &thread : mCheckThreads ) {
+		thread.join();
+	}
+}
+
+CompilerBase::Worker::Worker()
+	: id( 0 ), index( 0 ), busy( false ), cancelled( false ), job( 0 ), compileServerReady( false )
+{
+}
+
+CompilerBase::Worker::~Worker()
+{
+	// stop the process first, the reader thread uses the rest of the worker until then
+	process.reset();
+}
+
+std::string CompilerBase::getOutputHistory() const
+{
+	std::lock_guard<std::mutex> lock( mOutputHistoryMutex );
+	return mOutputHistory.getString();
+}
+
+void CompilerBase::setNumWorkers( size_t count )
+{
+	mNumWorkers = std::max<size_t>( 1, count );
+	// idle workers above the new limit can go, busy ones will be left alone
+	while( mWorkers.size() > mNumWorkers && ! mWorkers.back()->busy ) {
+		mWorkers.pop_back();
+	}
+	dispatchPendingJobs();
+}
+
+void CompilerBase::setCompileServer( const std::string &command )
+{
+	mCompileServer = command;
+	// idle workers start over with the new setting, busy ones are replaced once they are done
+	for( auto &worker : mWorkers ) {
+		if( ! worker->busy && worker->compileServer != mCompileServer ) {
+			replaceWorker( worker );
+		}
+	}
+	dispatchPendingJobs();
+}
+
+std::string CompilerBase::getCompileServerCommand() const
+{
+	// the shell only reads its input again once the server exits
+	return mCompileServer + " " + getShellCommandSeparator() + " echo " + std::string( sServerExitedMarker );
+}
+
+void CompilerBase::setBuildAgent( const std::string &address, const ci::fs::path &clientPath )
+{
+	mBuildAgent = address;
+	mBuildAgentClient = clientPath;
+}
+
+std::string CompilerBase::getShellFallbackCommand( const std::string &command, int status, const std::string &fallback ) const
+{
+	return command + "; rt_status=$?; if [ $rt_status -eq " + to_string( status ) + " ]; then " + fallback + "; else ( exit $rt_status ); fi";
+}
+
+std::string CompilerBase::getShellCommand( const PendingJob &job ) const
+{
+	auto buildIt = mBuilds.find( job.buildName );
+	if( mBuildAgent.empty() || buildIt == mBuilds.end() || buildIt->second.graph.getRemoteCompile( job.job ).arguments.empty() ) {
+		return job.command;
+	}
+
+	// the client sends the preprocessed source and writes the object it gets back, the job compiles locally if the agent can't be reached
+	const auto &remote = buildIt->second.graph.getRemoteCompile( job.job );
+	auto remoteCommand = quote( mBuildAgentClient.string() ) + " compile " + mBuildAgent + " " + quote( remote.inputPath ) + " " + quote( remote.outputPath ) + " -- " + remote.arguments;
+	return getShellFallbackCommand( remoteCommand, sAgentUnavailableStatus, job.command );
+}
+
+std::string CompilerBase::getBuildMarkerCommand( BuildMarker marker, const std::string &name ) const
+{
+	std::string command = "echo " + std::string( sBuildMarkerPrefix ) + ( marker == BuildMarker::BEGIN ? "begin " : "end " ) + to_string( name.size() ) + " " + name;
+	if( marker == BuildMarker::END ) {
+		command += " " + getShellStatusVariable();
+	}
+	return command;
+}
+
+void CompilerBase::dispatch( const std::string &name, const std::string &command, size_t job )
+{
+	// the most recent request goes first, it's the one the user is waiting for
+	mPendingJobs.push_front( { name, job, command } );
+	dispatchPendingJobs();
+}
+
+void CompilerBase::dispatchReadyJobs( const std::string &name )
+{
+	auto buildIt = mBuilds.find( name );
+	if( buildIt == mBuilds.end() ) {
+		return;
+	}
+
+	// jobs unblocked by a finished job go first too, builds that already started complete sooner
+	auto &graph = buildIt->second.graph;
+	std::vector<size_t> checkedJobs;
+	auto readyJobs = graph.startReadyJobs( &checkedJobs );
+	for( auto jobIt = readyJobs.rbegin(); jobIt != readyJobs.rend(); ++jobIt ) {
+		mPendingJobs.push_front( { name, *jobIt, graph.getCommand( *jobIt ) } );
+	}
+	// checks hash whole preprocessed sources and copy objects, they would stall the main loop
+	for( auto job : checkedJobs ) {
+		runUpToDateCheck( name, buildIt->second.id, job, graph.getUpToDateCheck( job ) );
+	}
+	dispatchPendingJobs();
+}
+
+void CompilerBase::runUpToDateCheck( const std::string &name, uint64_t buildId, size_t job, const std::function<bool()> &isUpToDate )
+{
+	{
+		std::lock_guard<std::mutex> lock( mCheckMutex );
+		mChecks.push_back( { name, buildId, job, isUpToDate, false } );
+		// checks mostly wait on the disk, one thread per core is plenty however many translation units there are
+		if( mCheckThreads.size() < std::max<size_t>( 1, std::thread::hardware_concurrency() ) ) {
+			mCheckThreads.emplace_back( &CompilerBase::checkThread, this );
+		}
+	}
+	mCheckCondition.notify_one();
 }
 
-void CompilerBase::parseProcessOutput()
+void CompilerBase::checkThread()
 {
-	string fullOutput;
-	while( mProcess->isOutputAvailable() ) {
-		auto output = removeEndline( mProcess->getOutputAsync() );
-		if( output.find( "error" ) != string::npos ) { 
-			mErrors.push_back( output );	
+	std::unique_lock<std::mutex> lock( mCheckMutex );
+	while( true ) {
+		mCheckCondition.wait( lock, [this]() { return mStopChecks || ! mChecks.empty(); } );
+		if( mStopChecks ) {
+			return;
 		}
-		else if( output.find( "warning" ) != string::npos ) {
-			mWarnings.push_back( output );
+
+		auto check = std::move( mChecks.front() );
+		mChecks.pop_front();
+		lock.unlock();
+		check.upToDate = check.isUpToDate();
+		check.isUpToDate = nullptr;
+		lock.lock();
+
+		// the outcome is kept until the main thread takes it, a build never waits on a check that got lost
+		mFinishedChecks.push_back( std::move( check ) );
+		if( auto app = app::App::get() ) {
+			app->dispatchAsync( [this]() { deliverFinishedChecks(); } );
 		}
-		fullOutput += output;
 	}
-	if( mVerbose && ! fullOutput.empty() ) app::console() << fullOutput << endl;
 }
 
-void CompilerBase::initializeProcess()
+void CompilerBase::deliverFinishedChecks()
 {
-	if( fs::exists( getCompilerPath() ) ) {
-		
-		// create a command line process with the right environment variables and paths
-		mProcess = make_unique<Process>( getCLInitCommand(), getCLInitPath().string(), true, true );
+	std::deque<Check> finishedChecks;
+	{
+		std::lock_guard<std::mutex> lock( mCheckMutex );
+		finishedChecks.swap( mFinishedChecks );
+	}
+	for( const auto &check : finishedChecks ) {
+		onCheckFinished( check.name, check.buildId, check.job, check.upToDate );
+	}
+}
+
+void CompilerBase::onCheckFinished( const std::string &name, uint64_t buildId, size_t job, bool upToDate )
+{
+	auto buildIt = mBuilds.find( name );
+	if( buildIt == mBuilds.end() || buildIt->second.id != buildId ) {
+		return;
+	}
+
+	auto &build = buildIt->second;
+	if( build.graph.finishCheck( job, upToDate ) ) {
+		mPendingJobs.push_front( { name, job, build.graph.getCommand( job ) } );
+		dispatchPendingJobs();
+	}
+	else if( build.graph.isFinished() ) {
+		// no worker ran the last job, the first one's prefix is used to report the build
+		bool succeeded = ! build.graph.hasFailed();
+		onBuildFinished( *mWorkers.front(), name );
+		resolveDependentBuilds( *mWorkers.front(), name, succeeded );
+	}
+	else {
+		dispatchReadyJobs( name );
+	}
+}
+
+bool CompilerBase::cancel( const std::string &name )
+{
+	bool cancelled = false;
+	
+	// pending jobs can simply be forgotten
+	auto pendingEnd = std::remove_if( mPendingJobs.begin(), mPendingJobs.end(), [&name]( const PendingJob &job ) { return job.buildName == name; } );
+	if( pendingEnd != mPendingJobs.end() ) {
+		mPendingJobs.erase( pendingEnd, mPendingJobs.end() );
+		cancelled = true;
+	}
+	
+	// running ones take their shell down with them and fresh shells take their place. The old workers are
+	// destroyed on the next main loop iteration as the cancellation might come from one of their callbacks
+	for( auto &worker : mWorkers ) {
+		if( worker->busy && worker->buildName == name ) {
+			replaceWorker( worker );
+			cancelled = true;
+		}
+	}
+
+	// the up to date checks still running for it are ignored
+	auto buildIt = mBuilds.find( name );
+	if( buildIt != mBuilds.end() ) {
+		buildIt->second.id = 0;
+	}
+
+	if( cancelled ) {
+		onBuildCancelled( name );
+	}
+	return cancelled;
+}
+
+void CompilerBase::dispatchPendingJobs()
+{
+	while( ! mPendingJobs.empty() ) {
+		Worker* worker = getIdleWorker();
+		if( ! worker ) {
+			break;
+		}
+
+		auto job = mPendingJobs.front();
+		mPendingJobs.pop_front();
+		worker->busy = true;
+		worker->buildName = job.buildName;
+		worker->job = job.job;
 		
-		// start the compiler process
-		mProcess << quote( getCompilerPath().string() ) + " " + getCompilerInitArgs() << endl;
+		// issue the job command framed by begin and end markers, a compile server prints the markers itself
+		if( worker->compileServer.empty() ) {
+			worker->process << getBuildMarkerCommand( BuildMarker::BEGIN, job.buildName ) << endl << getShellCommand( job ) << endl << getBuildMarkerCommand( BuildMarker::END, job.buildName ) << endl;
+		}
+		else {
+			worker->process << sBuildMarkerPrefix << "job " << job.buildName.size() << " " << job.buildName << endl << job.command << endl;
+		}
+	}
+}
+
+CompilerBase::Worker* CompilerBase::getIdleWorker()
+{
+	for( auto &worker : mWorkers ) {
+		if( ! worker->busy ) {
+			if( worker->compileServer != mCompileServer ) {
+				replaceWorker( worker );
+			}
+			// jobs wait until the compile server says it's ready
+			if( ! worker->compileServer.empty() && ! worker->compileServerReady ) {
+				continue;
+			}
+			return worker.get();
+		}
+	}
+	if( mWorkers.size() < mNumWorkers ) {
+		mWorkers.push_back( createWorker() );
+		mWorkers.back()->index = mWorkers.size() - 1;
+		return mWorkers.back()->compileServer.empty() ? mWorkers.back().get() : nullptr;
+	}
+	return nullptr;
+}
+
+CompilerBase::WorkerPtr CompilerBase::createWorker()
+{
+	auto worker = make_unique<Worker>();
+	worker->id = mNextWorkerId++;
+
+	// create a command line process with the right environment variables and paths. gcc and clang print their diagnostics and -H includes to StdErr, cl its /showIncludes, they are parsed with the rest of the output
+	worker->process = make_unique<Process>( getCLInitCommand(), getCLInitPath().string(), true, false, true, true );
+	// the shell lives as long as the app, its output is parsed as it arrives on the reader thread
+	worker->process->setSyncOutputLimit( 4096 );
+	Worker* workerPtr = worker.get();
+	worker->process->setOutputHandler( [this, workerPtr]( const char* data, size_t size ) {
+		parseOutput( *workerPtr, data, size );
+	} );
 		
-		// Connect the process redirection to cinder's console
-		mProcessOutputConnection = app::App::get()->getSignalUpdate().connect( bind( &CompilerBase::parseProcessOutput, this ) );
+	// start the compiler process, if the compiler needs one
+	if( ! getCompilerInitArgs().empty() ) {
+		worker->process << quote( getCompilerPath().string() ) + " " + getCompilerInitArgs() << endl;
+	}
+
+	// the compile server inherits the environment of the shell and reads the following jobs from its input
+	worker->compileServer = mCompileServer;
+	if( ! mCompileServer.empty() ) {
+		worker->process << getCompileServerCommand() << endl;
+	}
+
+	return worker;
+}
+
+void CompilerBase::replaceWorker( WorkerPtr &worker )
+{
+	worker->process->kill();
+	worker->cancelled = true;
+	auto newWorker = createWorker();
+	newWorker->index = worker->index;
+	// the old worker might be the one running the current callback
+	mCancelledWorkers.push_back( std::move( worker ) );
+	worker = std::move( newWorker );
+	app::App::get()->dispatchAsync( [this]() { mCancelledWorkers.clear(); } );
+}
+
+void CompilerBase::parseOutput( Worker &worker, const char* data, size_t size )
+{
+	// whatever a killed shell still prints is irrelevant
+	if( worker.cancelled ) {
+		return;
+	}
+	worker.outputLines.append( data, size, [this, &worker]( std::string_view line ) {
+		if( line == sServerReadyMarker ) {
+			postToWorker( worker.id, [this]( Worker &worker ) {
+				worker.compileServerReady = true;
+				dispatchPendingJobs();
+			} );
+			return;
+		}
+		if( line == sServerExitedMarker ) {
+			postToWorker( worker.id, [this]( Worker &worker ) {
+				onCompileServerExited( worker );
+			} );
+			return;
+		}
+		if( line.substr( 0, sAgentUnavailableMarker.size() ) == sAgentUnavailableMarker ) {
+			postToWorker( worker.id, [this, address = std::string( line.substr( sAgentUnavailableMarker.size() ) )]( Worker & ) {
+				onBuildAgentUnavailable( address );
+			} );
+			return;
+		}
+
+		bool begin;
+		std::string_view name;
+		int status;
+		if( parseBuildMarker( line, &begin, &name, &status ) ) {
+			if( begin ) {
+				worker.errors.clear();
+				worker.warnings.clear();
+				worker.dependencies.clear();
+				postToWorker( worker.id, [this, name = std::string( name )]( Worker &worker ) {
+					onJobStarted( worker, name );
+				} );
+			}
+			else {
+				// the worker's diagnostics stay untouched until the main thread hands it a new build
+				postToWorker( worker.id, [this, name = std::string( name ), status]( Worker &worker ) {
+					onJobFinished( worker, name, status );
+					worker.busy = false;
+					worker.buildName.clear();
+					dispatchPendingJobs();
+				} );
+			}
+		}
+		else {
+			parseLine( worker, line );
+		}
+	} );
+}
+
+void CompilerBase::postToWorker( uint64_t workerId, const std::function<void( Worker& )> &fn )
+{
+	app::App::get()->dispatchAsync( [this, workerId, fn]() {
+		auto workerIt = std::find_if( mWorkers.begin(), mWorkers.end(), [workerId]( const WorkerPtr &worker ) { return worker->id == workerId; } );
+		if( workerIt != mWorkers.end() ) {
+			fn( **workerIt );
+		}
+	} );
+}
+
+void CompilerBase::parseLine( Worker &worker, std::string_view line )
+{
+	std::lock_guard<std::mutex> lock( mOutputHistoryMutex );
+	mOutputHistory.push( line );
+	if( line.find( "error" ) != string::npos ) { 
+		worker.errors.push_back( formatDiagnostic( line ) );
+	}
+	else if( line.find( "warning" ) != string::npos ) {
+		worker.warnings.push_back( formatDiagnostic( line ) );
+	}
+	if( mVerbose && ! line.empty() ) app::console() << worker.index + 1 << ">" << line << endl;
+}
+
+void CompilerBase::onJobStarted( Worker &worker, std::string_view name )
+{
+	auto buildIt = mBuilds.find( std::string( name ) );
+	if( buildIt != mBuilds.end() ) {
+		auto prefix = to_string( worker.index + 1 ) + ">";
+		auto &build = buildIt->second;
+		if( ! build.started ) {
+			app::console() << endl << prefix << "------ Runtime Compiler Build started: " << getBuildDescription() << " ------" << endl;
+			build.started = true;
+		}
+		if( ! build.graph.getLabel( worker.job ).empty() ) {
+			app::console() << prefix << "  " << build.graph.getLabel( worker.job ) << endl;
+		}
+	}
+}
+
+void CompilerBase::onCompileServerExited( Worker &worker )
+{
+	// the job it was running won't reach its end marker anymore
+	if( worker.busy ) {
+		auto buildName = worker.buildName;
+		worker.errors.push_back( "Compile server exited" );
+		onJobFinished( worker, buildName, 1 );
+		worker.busy = false;
+		worker.buildName.clear();
+	}
+
+	// a server that never got ready is unlikely to do better next time
+	if( ! worker.compileServerReady && worker.compileServer == mCompileServer ) {
+		app::console() << "Compile server \"" << mCompileServer << "\" exited before accepting jobs, running the compiler directly" << endl;
+		mCompileServer.clear();
+	}
+
+	// and a new one takes its place
+	auto workerIt = std::find_if( mWorkers.begin(), mWorkers.end(), [&worker]( const WorkerPtr &other ) { return other.get() == &worker; } );
+	if( workerIt != mWorkers.end() ) {
+		replaceWorker( *workerIt );
+	}
+	dispatchPendingJobs();
+}
+
+void CompilerBase::onBuildAgentUnavailable( const std::string &address )
+{
+	// the jobs already sent to it compile locally as well
+	if( address == mBuildAgent ) {
+		app::console() << "Build agent " << mBuildAgent << " didn't respond, compiling locally" << endl;
+		mBuildAgent.clear();
+	}
+}
+
+void CompilerBase::onBuildCancelled( const std::string &name )
+{
+	auto buildIt = mBuilds.find( name );
+	if( buildIt != mBuilds.end() ) {
+		app::console() << "========== Runtime Compiler Build: " << buildIt->second.result.getFilePaths().front().filename() << " superseded by a newer build ==========" << endl;
+		mBuilds.erase( buildIt );
+	}
+}
+
+void CompilerBase::onJobFinished( Worker &worker, std::string_view name, int status )
+{
+	std::string buildName( name );
+	auto buildIt = mBuilds.find( buildName );
+	if( buildIt == mBuilds.end() ) {
+		return;
+	}
+	auto &build = buildIt->second;
+	auto prefix = to_string( worker.index + 1 ) + ">";
+
+	// a failing command that didn't print any recognizable error still fails the job
+	if( status != 0 && worker.errors.empty() ) {
+		worker.errors.push_back( "Build command exited with code " + to_string( status ) );
+	}
+
+	// hand this worker's diagnostics to the build result
+	auto &errors = build.result.getErrors();
+	auto &warnings = build.result.getWarnings();
+	errors.insert( errors.end(), worker.errors.begin(), worker.errors.end() );
+	warnings.insert( warnings.end(), worker.warnings.begin(), worker.warnings.end() );
+	build.result.getDependencies().insert( build.result.getDependencies().end(), worker.dependencies.begin(), worker.dependencies.end() );
+	for( auto warning : worker.warnings ) {
+		app::console() << prefix + warning << endl;
+	}
+	for( auto error : worker.errors ) {
+		app::console() << prefix + error << endl;
+	}
+
+	// after a failure the jobs that haven't started are skipped and the running ones are left to report their diagnostics
+	build.graph.finishJob( worker.job, worker.errors.empty() );
+	if( build.graph.hasFailed() ) {
+		dropPendingJobs( buildName, build.graph );
+	}
+
+	if( build.graph.isFinished() ) {
+		bool succeeded = ! build.graph.hasFailed();
+		onBuildFinished( worker, buildName );
+		resolveDependentBuilds( worker, buildName, succeeded );
+	}
+	else {
+		dispatchReadyJobs( buildName );
+	}
+}
+
+void CompilerBase::dropPendingJobs( const std::string &name, BuildGraph &graph )
+{
+	for( auto jobIt = mPendingJobs.begin(); jobIt != mPendingJobs.end(); ) {
+		if( jobIt->buildName == name ) {
+			graph.finishJob( jobIt->job, false );
+			jobIt = mPendingJobs.erase( jobIt );
+		}
+		else {
+			++jobIt;
+		}
+	}
+}
+
+void CompilerBase::resolveDependentBuilds( Worker &worker, const std::string &name, bool succeeded )
+{
+	std::vector<std::string> dependentBuilds;
+	for( auto &build : mBuilds ) {
+		if( build.second.graph.resolveExternalJobs( name, succeeded ) ) {
+			dependentBuilds.push_back( build.first );
+		}
+	}
+
+	for( const auto &dependentName : dependentBuilds ) {
+		auto buildIt = mBuilds.find( dependentName );
+		if( buildIt == mBuilds.end() ) {
+			continue;
+		}
+		auto &build = buildIt->second;
+		if( ! succeeded ) {
+			build.result.getErrors().push_back( "Required build " + name + " failed" );
+			dropPendingJobs( dependentName, build.graph );
+		}
+		if( build.graph.isFinished() ) {
+			bool dependentSucceeded = ! build.graph.hasFailed();
+			onBuildFinished( worker, dependentName );
+			resolveDependentBuilds( worker, dependentName, dependentSucceeded );
+		}
+		else {
+			dispatchReadyJobs( dependentName );
+		}
+	}
+}
+
+void CompilerBase::onBuildFinished( Worker &worker, const std::string &name )
+{
+	auto buildIt = mBuilds.find( name );
+	if( buildIt != mBuilds.end() ) {
+		auto prefix = to_string( worker.index + 1 ) + ">";
+		Build build = std::move( buildIt->second );
+		mBuilds.erase( buildIt );
+
+		// translation units of the same module share most of their headers
+		auto &dependencies = build.result.getDependencies();
+		std::sort( dependencies.begin(), dependencies.end() );
+		dependencies.erase( std::unique( dependencies.begin(), dependencies.end() ), dependencies.end() );
+
+		if( ! build.result.hasErrors() ) {
+			// modules linked by the ORC JIT have no output on disk
+			if( ! build.result.getOutputPath().empty() ) {
+				app::console() << prefix << "  " << build.result.getFilePaths().front().filename() << " -> " << build.result.getOutputPath() << endl;
+			}
+			if( ! build.result.getPdbFilePath().empty() ) {
+				app::console() << prefix << "  " << build.result.getFilePaths().front().filename() << " -> " << build.result.getPdbFilePath() << endl;
+			}
+			app::console() << "========== Runtime Compiler Build: 1 succeeded, 0 failed, 0 up-to-date, 0 skipped ==========" << endl;
+			auto elapsed = std::chrono::steady_clock::now() - build.startTime;
+			auto elapsedMicro = std::chrono::duration_cast<std::chrono::microseconds>( elapsed ).count();
+			auto elapsedMinutes = std::chrono::duration_cast<std::chrono::hours>( elapsed ).count();
+			auto elapsedHours = std::chrono::duration_cast<std::chrono::hours>( elapsed ).count();
+			std::ostringstream oss;
+			oss << std::setfill('0') << std::setw(2) << elapsedHours << ":" << std::setw(2) << elapsedMinutes << ":"
+				<< std::setw(2) << ( elapsedMicro % 1000000000 ) / 1000000 << "." << std::setw(3) << ( elapsedMicro % 1000000 ) / 1000;
+			app::console() << endl << "Time Elapsed " << oss.str() << endl << endl;
+			if( build.onBuildFinish ) {
+				build.onBuildFinish( build.result );
+			}
+		}
+		else {
+			app::console() << "========== Runtime Compiler Build: 0 succeeded, 1 failed, 0 up-to-date, 0 skipped ==========" << endl;
+		}
+	}
+}
+
+void CompilerBase::queueBuild( const std::string &name, const BuildGraph &graph, const CompilationResult &result, const std::function<void(const CompilationResult&)> &onBuildFinish )
+{
+	// outcomes that couldn't be posted because there was no app yet are picked up by the next build
+	deliverFinishedChecks();
+
+	auto &build = mBuilds[name];
+	build = { result, onBuildFinish, std::chrono::steady_clock::now(), graph, false, mNextBuildId++ };
+
+	// the builds this one waits for might already be done
+	for( const auto &externalName : build.graph.getPendingExternalJobs() ) {
+		if( externalName == name || ! isBuilding( externalName ) ) {
+			build.graph.resolveExternalJobs( externalName, true );
+		}
+	}
+	dispatchReadyJobs( name );
+}
+
+void CompilerBase::initializeProcess()
+{
+	if( fs::exists( getCompilerPath() ) ) {
+		// start the first worker right away so the first build doesn't pay for the shell initialization
+		mWorkers.push_back( createWorker() );
 	}
 	else {
 		throw CompilerException( "Failed Initializing Compiler Process at " + getCompilerPath().string() );
@@ -116,6 +729,14 @@ std::vector<std::string>& CompilationResult::getWarnings()
 {
 	return mWarnings;
 }
+const std::vector<ci::fs::path>& CompilationResult::getDependencies() const
+{
+	return mDependencies;
+}
+std::vector<ci::fs::path>& CompilationResult::getDependencies()
+{
+	return mDependencies;
+}
 void CompilationResult::setOutputPath( const ci::fs::path &path )
 {
 	mOutputPath = path;
@@ -0,0 +1,940 @@
+#include "cinder/Cinder.h"
+
+#if ! defined( CINDER_MSW )
+
+#include "runtime/CompilerGcc.h"
+#include "runtime/ClassFactory.h"
+#include "runtime/ObjectCache.h"
+#include "runtime/PrecompiledHeader.h"
+#include "runtime/Process.h"
+#include "runtime/SymbolIndex.h"
+#include "runtime/UnityBuild.h"
+
+#include "cinder/app/App.h"
+#include "cinder/Json.h"
+#include "cinder/Log.h"
+#include "cinder/Utilities.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#define RT_VERBOSE_DEFAULT 0
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+namespace {
+
+	//! Splits a shell command line into arguments, handling quotes and backslash escapes
+	std::vector<std::string> splitCommandLine( const std::string &commandLine )
+	{
+		std::vector<std::string> arguments;
+		std::string current;
+		bool hasArgument = false;
+		char quote = 0;
+		for( size_t i = 0; i < commandLine.size(); ++i ) {
+			char c = commandLine[i];
+			if( quote ) {
+				if( c == quote ) {
+					quote = 0;
+				}
+				else if( c == '\\' && quote == '"' && i + 1 < commandLine.size() ) {
+					current += commandLine[++i];
+				}
+				else {
+					current += c;
+				}
+			}
+			else if( c == '"' || c == '\'' ) {
+				quote = c;
+				hasArgument = true;
+			}
+			else if( c == '\\' && i + 1 < commandLine.size() ) {
+				current += commandLine[++i];
+				hasArgument = true;
+			}
+			else if( c == ' ' || c == '\t' || c == '\n' ) {
+				if( hasArgument ) {
+					arguments.push_back( current );
+					current.clear();
+					hasArgument = false;
+				}
+			}
+			else {
+				current += c;
+				hasArgument = true;
+			}
+		}
+		if( hasArgument ) {
+			arguments.push_back( current );
+		}
+		return arguments;
+	}
+
+	//! Single-quotes argument for sh
+	std::string quoteArgument( const std::string &argument )
+	{
+		std::string quoted = "'";
+		for( char c : argument ) {
+			if( c == '\'' ) {
+				quoted += "'\\''";
+			}
+			else {
+				quoted += c;
+			}
+		}
+		return quoted + "'";
+	}
+
+	//! Returns the full path of an executable looked up in PATH, or an empty path
+	fs::path findExecutable( const std::string &name )
+	{
+		if( name.find( '/' ) != string::npos ) {
+			return fs::exists( name ) ? fs::path( name ) : fs::path();
+		}
+		const char* pathVariable = std::getenv( "PATH" );
+		for( const auto &directory : ci::split( pathVariable ? pathVariable : "/usr/local/bin:/usr/bin:/bin", ":" ) ) {
+			if( ! directory.empty() && fs::exists( fs::path( directory ) / name ) ) {
+				return fs::path( directory ) / name;
+			}
+		}
+		return fs::path();
+	}
+
+	struct ProjectConfiguration {
+		ProjectConfiguration()
+		{
+			// look for the CMake build directory the executable lives in
+			fs::path appPath = app::getAppPath();
+			const size_t maxDepth = 20;
+			size_t depth = 0;
+			for( fs::path path = appPath; path.has_parent_path() || ( path == appPath ); path = path.parent_path(), ++depth ) {
+				if( depth >= maxDepth || ! buildDir.empty() )
+					break;
+				if( fs::exists( path / "CMakeCache.txt" ) ) {
+					buildDir = path;
+				}
+			}
+
+			if( buildDir.empty() ) {
+				string msg = "Failed to find the CMake build directory for this executable.";
+				msg += " Searched up " + to_string( maxDepth ) + " levels from app path: " + appPath.string();
+				throw CompilerException( msg );
+			}
+
+		#if defined( CINDER_LINUX )
+			std::error_code errorCode;
+			auto executablePath = fs::read_symlink( "/proc/self/exe", errorCode );
+			if( ! errorCode ) {
+				targetName = executablePath.stem().string();
+			}
+		#endif
+
+			setBuildDir( buildDir );
+
+	#if defined( __x86_64__ )
+			platform = "x86_64";
+	#elif defined( __aarch64__ )
+			platform = "arm64";
+	#else
+			platform = "x86";
+	#endif
+
+	#if defined( NDEBUG )
+			configuration = "Release";
+	#else
+			configuration = "Debug";
+	#endif
+		}
+
+		//! Reads the project name and source directory from the CMake cache and the arguments of the app's sources from compile_commands.json
+		void setBuildDir( const fs::path &path )
+		{
+			buildDir = path;
+			compileCommandsPath = buildDir / "compile_commands.json";
+
+			std::ifstream cacheFile( buildDir / "CMakeCache.txt" );
+			for( string line; std::getline( cacheFile, line ); ) {
+				auto separator = line.find( '=' );
+				if( separator == string::npos || line.empty() || line[0] == '#' || line[0] == '/' )
+					continue;
+				auto key = line.substr( 0, line.find( ':' ) );
+				auto value = line.substr( separator + 1 );
+				if( key == "CMAKE_PROJECT_NAME" ) {
+					projectName = value;
+				}
+				else if( key == "CMAKE_HOME_DIRECTORY" ) {
+					projectDir = value;
+				}
+			}
+			if( targetName.empty() ) {
+				targetName = projectName;
+			}
+
+			compileArguments.clear();
+			compileDirectory.clear();
+			if( fs::exists( compileCommandsPath ) ) {
+				try {
+					JsonTree compileCommands( loadFile( compileCommandsPath ) );
+					// prefer a source of the app target, its flags are the ones the module has to match
+					const JsonTree* entry = nullptr;
+					for( const auto &command : compileCommands.getChildren() ) {
+						if( ! entry ) {
+							entry = &command;
+						}
+						if( command.hasChild( "output" ) && command.getValueForKey<string>( "output" ).find( "CMakeFiles/" + targetName + ".dir/" ) != string::npos ) {
+							entry = &command;
+							break;
+						}
+						if( command.hasChild( "command" ) && command.getValueForKey<string>( "command" ).find( "CMakeFiles/" + targetName + ".dir/" ) != string::npos ) {
+							entry = &command;
+							break;
+						}
+					}
+					if( entry ) {
+						if( entry->hasChild( "arguments" ) ) {
+							for( const auto &argument : entry->getChild( "arguments" ).getChildren() ) {
+								compileArguments.push_back( argument.getValue<string>() );
+							}
+						}
+						else if( entry->hasChild( "command" ) ) {
+							compileArguments = splitCommandLine( entry->getValueForKey<string>( "command" ) );
+						}
+						if( entry->hasChild( "directory" ) ) {
+							compileDirectory = entry->getValueForKey<string>( "directory" );
+						}
+						if( entry->hasChild( "file" ) ) {
+							compileFile = entry->getValueForKey<string>( "file" );
+						}
+					}
+				}
+				catch( const std::exception &exc ) {
+					CI_LOG_E( "Failed parsing " << compileCommandsPath << ": " << exc.what() );
+				}
+			}
+		}
+
+		string printToString() const
+		{
+			stringstream str;
+
+			str << "buildDir: " << buildDir << ", projectName: " << projectName << ", targetName: " << targetName
+				<< "\n\t- configuration: " << configuration << ", platform: " << platform << ", compile commands: " << compileCommandsPath;
+
+			return str.str();
+		}
+
+		string configuration;
+		string platform;
+		string projectName;
+		string targetName;
+		fs::path projectDir;
+		fs::path buildDir;
+		fs::path compileCommandsPath;
+		fs::path compileDirectory;
+		string compileFile;
+		std::vector<string> compileArguments;
+	};
+
+	ProjectConfiguration& getProjectConfiguration()
+	{
+		static ProjectConfiguration config;
+		return config;
+	}
+
+	//! Adds the flags the app sources are compiled with to settings
+	void parseCompileArguments( CompilerGcc::BuildSettings* settings, const ProjectConfiguration &config )
+	{
+		const auto &arguments = config.compileArguments;
+		auto resolve = [&config]( const std::string &path ) {
+			return fs::path( path ).is_absolute() || config.compileDirectory.empty() ? fs::path( path ) : config.compileDirectory / path;
+		};
+		// the first argument is the compiler itself
+		for( size_t i = 1; i < arguments.size(); ++i ) {
+			const auto &argument = arguments[i];
+			bool hasNext = i + 1 < arguments.size();
+			// output, input and dependency file generation are specific to each source
+			if( argument == "-c" || argument == "-MD" || argument == "-MMD" || argument == "--" || argument == config.compileFile ) {
+				continue;
+			}
+			else if( ( argument == "-o" || argument == "-MF" || argument == "-MT" || argument == "-MQ" || argument == "-x" ) && hasNext ) {
+				++i;
+			}
+			else if( argument.compare( 0, 2, "-D" ) == 0 ) {
+				settings->define( argument.size() > 2 ? argument.substr( 2 ) : ( hasNext ? arguments[++i] : "" ) );
+			}
+			else if( argument.compare( 0, 2, "-I" ) == 0 ) {
+				settings->include( resolve( argument.size() > 2 ? argument.substr( 2 ) : ( hasNext ? arguments[++i] : "" ) ) );
+			}
+			else if( ( argument == "-isystem" || argument == "-iquote" || argument == "-idirafter" || argument == "-include" ) && hasNext ) {
+				settings->compilerOption( argument + " " + quoteArgument( resolve( arguments[++i] ).string() ) );
+			}
+			else if( argument.empty() || argument[0] != '-' ) {
+				// another source file
+				continue;
+			}
+			else {
+				settings->compilerOption( argument );
+			}
+		}
+	}
+
+	std::string trimProjectDir( std::string_view s )
+	{
+		auto projectDir = getProjectConfiguration().projectDir.generic_string();
+		auto it = projectDir.empty() ? std::string::npos : s.find( projectDir );
+		if( it != std::string::npos ) {
+			return std::string( s.substr( 0, it ) ) + std::string( s.substr( it + projectDir.length() ) );
+		}
+		else {
+			return std::string( s );
+		}
+	}
+
+	//! Writes the app objects needed by the module's objects to responsePath, or every app object if the module's objects can't be indexed
+	void writeAppObjectsResponseFile( const fs::path &responsePath, const fs::path &indexPath, const std::vector<fs::path> &moduleObjects, const std::vector<fs::path> &appObjects, bool verbose )
+	{
+		auto &symbolIndex = SymbolIndex::instance();
+		symbolIndex.load( indexPath );
+		std::vector<fs::path> neededObjects;
+		if( ! symbolIndex.getLinkClosure( moduleObjects, appObjects, &neededObjects ) ) {
+			neededObjects = appObjects;
+		}
+		symbolIndex.save();
+
+		if( verbose ) {
+			CI_LOG_I( "linking " << neededObjects.size() << " of " << appObjects.size() << " app objects" );
+		}
+
+		std::ofstream responseFile( responsePath );
+		for( const auto &obj : neededObjects ) {
+			responseFile << quoteArgument( obj.string() ) << endl;
+		}
+	}
+	//! Replaces the language standard of options by C++20 when it is older or missing, header units need it. GNU extensions stay on unless they were explicitly off.
+	void requireCpp20( std::vector<std::string> *options )
+	{
+		bool gnu = true;
+		for( auto it = options->begin(); it != options->end(); ) {
+			auto separator = it->find( "++" );
+			if( it->compare( 0, 5, "-std=" ) == 0 && separator != string::npos ) {
+				auto version = it->substr( separator + 2 );
+				if( version == "20" || version == "2a" || version == "23" || version == "2b" || version == "26" || version == "2c" ) {
+					return;
+				}
+				gnu = it->compare( 5, 3, "gnu" ) == 0;
+				it = options->erase( it );
+			}
+			else {
+				++it;
+			}
+		}
+		options->push_back( gnu ? "-std=gnu++20" : "-std=c++20" );
+	}
+
+	//! Lists the header unit compiled in directory in the format of -fmodule-mapper, then gathers the lists of every header unit next to it in mapperPath
+	void writeHeaderUnitMapper( const fs::path &directory, const fs::path &mapperPath )
+	{
+		// gcc mirrors the path the header resolved to under gcm.cache, which is also the name it imports it by
+		auto cacheDir = directory / "gcm.cache";
+		std::ofstream unitFile( directory / "HeaderUnit.map" );
+		if( fs::exists( cacheDir ) ) {
+			for( auto it = fs::recursive_directory_iterator( cacheDir ), end = fs::recursive_directory_iterator(); it != end; it++ ) {
+				if( it->path().extension() == ".gcm" ) {
+					auto name = fs::relative( it->path(), cacheDir ).replace_extension().generic_string();
+					// older versions prefix absolute paths with a comma
+					name = name.compare( 0, 2, ",/" ) == 0 ? name.substr( 1 ) : "/" + name;
+					unitFile << name << " " << it->path().generic_string() << endl;
+				}
+			}
+		}
+		unitFile.close();
+
+		// the mapper is replaced at once, modules reading it might be compiling
+		auto tempPath = mapperPath.string() + ".tmp";
+		std::ofstream mapperFile( tempPath );
+		for( const auto &entry : fs::directory_iterator( mapperPath.parent_path() ) ) {
+			std::ifstream entryFile( entry.path() / "HeaderUnit.map" );
+			for( string line; std::getline( entryFile, line ); ) {
+				mapperFile << line << endl;
+			}
+		}
+		mapperFile.close();
+		std::error_code errorCode;
+		fs::rename( tempPath, mapperPath, errorCode );
+	}
+} // anonymous namespace
+
+// the other constructors start from these defaults
+BuildSettings::BuildSettings()
+: mVerbose( RT_VERBOSE_DEFAULT ), mLinkAppObjs( true ), mLinkHostExports( false ), mGenerateFactory( true ), mGeneratePch( false ), mUsePch( true ), mUseObjectCache( true ), mUseSymbolIndex( true ), mUseOrcJit( false ), mUnitySize( 0 ), mConfiguration( getProjectConfiguration().configuration ), mPlatform( getProjectConfiguration().platform )
+{
+}
+
+BuildSettings::BuildSettings( bool defaultSettings )
+: BuildSettings()
+{
+	compilerOption( "-fPIC" )
+#if ! defined( NDEBUG )
+	.compilerOption( "-g" )
+	.compilerOption( "-O0" )
+#endif
+	.define( "RT_COMPILED" )
+
+	// cinder-runtime include
+	.include( fs::absolute(  fs::path( __FILE__ ).parent_path().parent_path().parent_path() / "include" ) )
+	.intermediatePath( getProjectConfiguration().buildDir )
+	;
+
+	if( defaultSettings && ! getProjectConfiguration().compileArguments.empty() ) {
+		parseCompileArguments( this, getProjectConfiguration() );
+	}
+	else {
+		if( defaultSettings ) {
+			CI_LOG_W( "No compile_commands.json found in " << getProjectConfiguration().buildDir << ", configure the project with -DCMAKE_EXPORT_COMPILE_COMMANDS=ON to build modules with the app's flags." );
+		}
+		compilerOption( "-std=c++17" );
+	}
+}
+
+BuildSettings::BuildSettings( const ci::fs::path &projectPath )
+: BuildSettings()
+{
+	getProjectConfiguration().setBuildDir( fs::is_directory( projectPath ) ? projectPath : projectPath.parent_path() );
+	if( ! fs::is_directory( projectPath ) ) {
+		getProjectConfiguration().compileCommandsPath = projectPath;
+	}
+
+	compilerOption( "-fPIC" )
+#if ! defined( NDEBUG )
+	.compilerOption( "-g" )
+	.compilerOption( "-O0" )
+#endif
+	.define( "RT_COMPILED" )
+
+	// cinder-runtime include
+	.include( fs::absolute(  fs::path( __FILE__ ).parent_path().parent_path().parent_path() / "include" ) )
+	.intermediatePath( getProjectConfiguration().buildDir );
+
+	parseCompileArguments( this, getProjectConfiguration() );
+}
+
+std::string CompilerGcc::printToString() const
+{
+	stringstream str;
+
+	str << "Compiler path: " << getCompilerPath() << ( mIsClang ? " (clang)" : "" ) << endl;
+	str << "Subprocess path: " << getCLInitPath() << endl;
+
+	return str.str();
+}
+
+void CompilerGcc::debugLog( BuildSettings *settings ) const
+{
+	CI_LOG_I( "Compiler Settings: " << CompilerGcc::instance().printToString() );
+	CI_LOG_I( "ProjectConfiguration: " << getProjectConfiguration().printToString() );
+
+	if( settings ) {
+		CI_LOG_I( "BuildSettings: " << settings->printToString() );
+	}
+}
+
+CompilerGcc::CompilerGcc()
+	: mIsClang( getCompilerPath().filename().string().find( "clang" ) != string::npos )
+{
+	if( mVerbose ) {
+		CI_LOG_I( "Compiler Settings: \n" << printToString() );
+	}
+
+	initializeProcess();
+}
+
+CompilerGcc::~CompilerGcc()
+{
+}
+
+CompilerGcc& CompilerGcc::instance()
+{
+	static CompilerGccPtr compiler = make_unique<CompilerGcc>();
+	return *compiler.get();
+}
+
+void CompilerGcc::build( const std::string &arguments, const std::function<void( const CompilationResult& )> &onBuildFinish )
+{
+	if( mWorkers.empty() ) {
+		throw CompilerException( "Compiler Process not initialized" );
+	}
+
+	// a build of a single job, named after its command so running it again supersedes the previous one
+	cancel( arguments );
+	BuildGraph graph;
+	graph.addJob( "", arguments );
+	queueBuild( arguments, graph, CompilationResult(), onBuildFinish );
+}
+
+std::string CompilerGcc::getCLInitCommand() const
+{
+	return "sh";
+}
+
+ci::fs::path CompilerGcc::getCLInitPath() const
+{
+	return getProjectConfiguration().buildDir;
+}
+
+ci::fs::path CompilerGcc::getCompilerPath() const
+{
+	// an explicit choice first, then the compiler the app has been built with
+	if( const char* compiler = std::getenv( "RT_CXX" ) ) {
+		return findExecutable( compiler );
+	}
+	if( ! getProjectConfiguration().compileArguments.empty() ) {
+		auto compiler = findExecutable( getProjectConfiguration().compileArguments.front() );
+		if( ! compiler.empty() ) {
+			return compiler;
+		}
+	}
+	if( const char* compiler = std::getenv( "CXX" ) ) {
+		return findExecutable( compiler );
+	}
+	return findExecutable( "c++" );
+}
+
+std::string CompilerGcc::getCompilerInitArgs() const
+{
+	// nothing to set up, the shell already has the right environment
+	return "";
+}
+
+std::string CompilerGcc::generateCompilerFlags( const BuildSettings &settings ) const
+{
+	string flags;
+	for( const auto &define : settings.mPpDefinitions ) {
+		flags += quoteArgument( "-D" + define ) + " ";
+	}
+	for( const auto &include : settings.mIncludes ) {
+		flags += "-I" + quoteArgument( include.generic_string() ) + " ";
+	}
+	for( const auto &include : settings.mForcedIncludes ) {
+		flags += "-include " + quoteArgument( include ) + " ";
+	}
+	for( const auto &compilerArg : settings.mCompilerOptions ) {
+		flags += compilerArg + " ";
+	}
+	return flags;
+}
+
+ci::fs::path CompilerGcc::getPrecompiledHeaderOutputPath( const PrecompiledHeaderPool::Entry &entry ) const
+{
+	// gcc picks up the .gch next to the header while clang needs it explicitly
+	return mIsClang ? entry.directory / "Pch.h.pch" : entry.directory / "Pch.h.gch";
+}
+
+std::string CompilerGcc::generatePrecompiledHeaderCommand( const PrecompiledHeaderPool::Entry &entry, const ci::fs::path &sourceDir, const BuildSettings &settings ) const
+{
+	// the headers it includes are listed so the entry is only rebuilt when one of them changes
+	string command = quoteArgument( getCompilerPath().string() ) + " -x c++-header -H " + generateCompilerFlags( settings );
+	// quoted includes of the pool header are looked up in the directory of the sources it was extracted from
+	command += "-I" + quoteArgument( sourceDir.generic_string() ) + " ";
+	// clang would otherwise reject the pch after a header is saved without changes
+	if( mIsClang ) {
+		command += "-Xclang -fno-pch-timestamp ";
+	}
+	command += "-o " + quoteArgument( getPrecompiledHeaderOutputPath( entry ).string() ) + " " + quoteArgument( entry.header.string() );
+
+	if( settings.isVerboseEnabled() ) {
+		CI_LOG_I( "command:\n" << command );
+	}
+
+	return command;
+}
+
+std::string CompilerGcc::queuePrecompiledHeader( const ci::fs::path &sourcePath, const BuildSettings &settings, std::string *pchFlags, PrecompiledHeaderPool::Entry *pchEntry )
+{
+	pchFlags->clear();
+	if( ! settings.mUsePch ) {
+		return string();
+	}
+
+	// modules with the same includes and flags share the same precompiled header
+	PrecompiledHeaderPool pool( settings.getIntermediatePath() / "runtime" / "pch" );
+	PrecompiledHeaderPool::Entry entry;
+	auto sourceDir = sourcePath.parent_path();
+	if( ! pool.acquire( getPrecompiledHeaderIncludes( sourcePath ), generateCompilerFlags( settings ) + "-I" + quoteArgument( sourceDir.generic_string() ), &entry ) ) {
+		return string();
+	}
+	*pchEntry = entry;
+
+	auto pchPath = getPrecompiledHeaderOutputPath( entry );
+	*pchFlags = mIsClang ? "-include-pch " + quoteArgument( pchPath.string() ) + " " : "-include " + quoteArgument( entry.header.string() ) + " ";
+
+	// the first module needing it builds it, the others wait for that build
+	auto pchBuildName = "pch:" + entry.key;
+	if( ! isBuilding( pchBuildName ) && ( ! pool.isUpToDate( entry, pchPath ) || settings.mGeneratePch ) ) {
+		pool.invalidate( entry );
+		BuildGraph graph;
+		graph.addJob( entry.header.filename().string(), generatePrecompiledHeaderCommand( entry, sourceDir, settings ) );
+		CompilationResult result;
+		result.getFilePaths().push_back( entry.header );
+		result.setOutputPath( pchPath );
+		queueBuild( pchBuildName, graph, result, [pool,entry]( const CompilationResult &pchResult ) {
+			pool.recordDependencies( entry, pchResult.getDependencies() );
+		} );
+	}
+
+	return pchBuildName;
+}
+
+std::string CompilerGcc::generateHeaderUnitCommand( const PrecompiledHeaderPool::Entry &entry, const BuildSettings &settings ) const
+{
+	// the unit lands in the gcm.cache of the working directory, under the path the header resolved to
+	string command = "( cd " + quoteArgument( entry.directory.string() ) + " && " + quoteArgument( getCompilerPath().string() ) + " -H " + generateCompilerFlags( settings );
+	command += "-fmodules-ts -fmodule-header=system -x c++-system-header " + quoteArgument( entry.header.generic_string() ) + " )";
+
+	if( settings.isVerboseEnabled() ) {
+		CI_LOG_I( "command:\n" << command );
+	}
+
+	return command;
+}
+
+std::vector<std::string> CompilerGcc::queueHeaderUnits( const BuildSettings &settings, std::string *headerUnitFlags )
+{
+	headerUnitFlags->clear();
+	std::vector<std::string> buildNames;
+	if( settings.mHeaderUnits.empty() ) {
+		return buildNames;
+	}
+
+	// the modules built with the same flags share the header units and a mapper importing all of them
+	PrecompiledHeaderPool pool( settings.getIntermediatePath() / "runtime" / "header-units" );
+	auto flags = generateCompilerFlags( settings );
+	auto mapperPath = pool.getHeaderUnitsDirectory( flags ) / "HeaderUnits.map";
+	for( const auto &header : settings.mHeaderUnits ) {
+		PrecompiledHeaderPool::Entry entry;
+		pool.acquireHeaderUnit( header, flags, &entry );
+		auto buildName = "header-unit:" + entry.key;
+		if( ! isBuilding( buildName ) && ! pool.isUpToDate( entry, entry.directory / "HeaderUnit.map" ) ) {
+			pool.invalidate( entry );
+			BuildGraph graph;
+			graph.addJob( header, generateHeaderUnitCommand( entry, settings ) );
+			CompilationResult result;
+			result.getFilePaths().push_back( header );
+			result.setOutputPath( mapperPath );
+			queueBuild( buildName, graph, result, [pool,entry,mapperPath]( const CompilationResult &headerUnitResult ) {
+				writeHeaderUnitMapper( entry.directory, mapperPath );
+				pool.recordDependencies( entry, headerUnitResult.getDependencies() );
+			} );
+		}
+		buildNames.push_back( buildName );
+	}
+
+	*headerUnitFlags = "-fmodules-ts -fmodule-mapper=" + quoteArgument( mapperPath.string() ) + " ";
+	return buildNames;
+}
+
+std::string CompilerGcc::generateCompilerCommand( const ci::fs::path &sourcePath, const ci::fs::path &objectPath, const BuildSettings &settings, const std::string &pchFlags ) const
+{
+	// the preprocessing job lists the includes when the object cache is used, otherwise the compiler does
+	string command = quoteArgument( getCompilerPath().string() ) + ( settings.mUseObjectCache ? " -c " : " -c -H " ) + generateCompilerFlags( settings ) + pchFlags;
+	command += "-I" + quoteArgument( sourcePath.parent_path().generic_string() ) + " ";
+	command += "-o " + quoteArgument( objectPath.string() ) + " " + quoteArgument( sourcePath.generic_string() );
+
+	if( settings.isVerboseEnabled() ) {
+		CI_LOG_I( "command:\n" << command );
+	}
+
+	return command;
+}
+
+std::string CompilerGcc::generateLinkerCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, CompilationResult* result ) const
+{
+	string command = quoteArgument( getCompilerPath().string() ) + " -shared ";
+
+	auto outputPath = settings.mOutputPath.empty() ? ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + getModuleExtension() ) ) : settings.mOutputPath;
+	result->setOutputPath( outputPath );
+	command += "-o " + quoteArgument( outputPath.string() ) + " ";
+
+	// objects of the translation units compiled by the other jobs
+	for( const auto &obj : result->getObjectFilePaths() ) {
+		command += quoteArgument( obj.string() ) + " ";
+	}
+	for( const auto &obj : settings.mObjPaths ) {
+		command += quoteArgument( obj.string() ) + " ";
+		result->getObjectFilePaths().push_back( obj );
+	}
+
+	// symbols exported by the executable (-rdynamic) are resolved when the module is loaded
+	if( settings.mLinkHostExports ) {
+	#if defined( CINDER_MAC )
+		command += "-Wl,-undefined,dynamic_lookup ";
+	#endif
+	}
+	else if( settings.mLinkAppObjs ) {
+		// CMake keeps the objects of the app target in CMakeFiles/<target>.dir
+		auto appObjsDir = getProjectConfiguration().buildDir / "CMakeFiles" / ( getProjectConfiguration().targetName + ".dir" );
+		std::vector<fs::path> appObjects;
+		if( fs::exists( appObjsDir ) ) {
+			for( auto it = fs::recursive_directory_iterator( appObjsDir ), end = fs::recursive_directory_iterator(); it != end; it++ ) {
+				if( it->path().extension() == ".o" ) {
+					// Skip obj for current source and current app
+					if( it->path().filename().string() != sourcePath.filename().string() + ".o"
+						&& it->path().filename().string() != getProjectConfiguration().projectName + "App.cpp.o"
+						) {
+						appObjects.push_back( it->path() );
+					}
+				}
+			}
+		}
+		// the objects the module needs are only known once its own objects are compiled, the link job lists them right before starting
+		if( settings.mUseSymbolIndex && ! appObjects.empty() ) {
+			command += "@" + quoteArgument( getAppObjectsResponsePath( settings ).string() ) + " ";
+		}
+		else {
+			for( const auto &obj : appObjects ) {
+				command += quoteArgument( obj.string() ) + " ";
+			}
+		}
+		result->getObjectFilePaths().insert( result->getObjectFilePaths().end(), appObjects.begin(), appObjects.end() );
+	}
+
+	for( const auto &libraryPath : settings.mLibraryPaths ) {
+		command += "-L" + quoteArgument( libraryPath.generic_string() ) + " ";
+	}
+	for( const auto &library : settings.mLibraries ) {
+		// bare names are looked up in the library paths, files are linked as they are
+		bool isFile = library.find( '/' ) != string::npos || fs::path( library ).extension() == ".a" || fs::path( library ).extension() == ".so";
+		command += ( isFile ? quoteArgument( library ) : "-l" + library ) + " ";
+	}
+	for( const auto &linkerArg : settings.mLinkerOptions ) {
+		command += linkerArg + " ";
+	}
+
+	return command;
+}
+
+ci::fs::path CompilerGcc::getAppObjectsResponsePath( const BuildSettings &settings ) const
+{
+	return settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + "AppObjs.rsp" );
+}
+
+std::string CompilerGcc::generatePreprocessorCommand( const ci::fs::path &sourcePath, const ci::fs::path &preprocessedPath, const BuildSettings &settings ) const
+{
+	string command = quoteArgument( getCompilerPath().string() ) + " -E -H " + generateCompilerFlags( settings );
+	command += "-I" + quoteArgument( sourcePath.parent_path().generic_string() ) + " ";
+	command += "-o " + quoteArgument( preprocessedPath.string() ) + " " + quoteArgument( sourcePath.generic_string() );
+	return command;
+}
+
+std::string CompilerGcc::generatePreprocessedCompilerArguments( const std::string &inputPath, const std::string &outputPath, const BuildSettings &settings ) const
+{
+	// the preprocessed source needs neither the includes nor the definitions
+	string arguments = "-c -x c++-cpp-output ";
+	for( const auto &compilerArg : settings.mCompilerOptions ) {
+		arguments += compilerArg + " ";
+	}
+	return arguments + "-o " + quoteArgument( outputPath ) + " " + quoteArgument( inputPath );
+}
+
+BuildGraph CompilerGcc::generateBuildGraph( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::vector<std::string> &pchBuildNames, const std::string &pchFlags, CompilationResult* result ) const
+{
+	BuildGraph graph;
+
+	// every translation unit waits for the builds of the shared precompiled header or header units that are running
+	std::vector<size_t> pchJob;
+	for( const auto &pchBuildName : pchBuildNames ) {
+		pchJob.push_back( graph.addExternalJob( pchBuildName ) );
+	}
+
+	// then they compile concurrently on separate workers, unless the cache has an object for the same preprocessed source
+	auto buildDir = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build";
+	ObjectCache objectCache( settings.getIntermediatePath() / "runtime" / "cache" );
+	std::vector<fs::path> sources = { sourcePath };
+	sources.insert( sources.end(), settings.mAdditionalSources.begin(), settings.mAdditionalSources.end() );
+	result->getFilePaths().insert( result->getFilePaths().end(), sources.begin() + 1, sources.end() );
+	// a unity build compiles groups of sources as a single translation unit, the precompiled header and the cache work the same on them
+	auto translationUnits = settings.mUnitySize ? generateUnitySources( sources, settings.mUnityExclusions, settings.mUnitySize, buildDir.parent_path(), settings.getModuleName() ) : sources;
+	auto remoteArguments = generatePreprocessedCompilerArguments( "{input}", "{output}", settings );
+	std::vector<size_t> objectJobs;
+	for( size_t i = 0; i < translationUnits.size(); ++i ) {
+		auto objectPath = buildDir / ( translationUnits[i].stem().string() + ".o" );
+		if( ! settings.mObjectFilePath.empty() ) {
+			objectPath = fs::is_directory( settings.mObjectFilePath ) ? settings.mObjectFilePath / ( translationUnits[i].stem().string() + ".o" ) : ( i == 0 ? settings.mObjectFilePath : objectPath );
+		}
+		if( settings.mUseObjectCache ) {
+			// the preprocessor also lists the headers the module depends on
+			auto preprocessedPath = buildDir / ( translationUnits[i].stem().string() + ".i" );
+			auto preprocessorCommand = generatePreprocessorCommand( translationUnits[i], preprocessedPath, settings );
+			// the object is compiled from the preprocessed source the cache key is computed from, a source edited in the meantime can't be stored under that key
+			auto cachedCompilerCommand = quoteArgument( getCompilerPath().string() ) + " " + generatePreprocessedCompilerArguments( preprocessedPath.string(), objectPath.string(), settings );
+			objectJobs.push_back( objectCache.addCompileJobs( &graph, translationUnits[i].filename().string(), preprocessorCommand, preprocessedPath, cachedCompilerCommand, objectPath, pchJob ) );
+			// a cache miss can compile on a build agent, the preprocessed source is all it needs
+			graph.setRemoteCompile( objectJobs.back(), { remoteArguments, preprocessedPath.string(), objectPath.string() } );
+		}
+		else {
+			objectJobs.push_back( graph.addJob( translationUnits[i].filename().string(), generateCompilerCommand( translationUnits[i], objectPath, settings, pchFlags ), pchJob ) );
+		}
+		result->getObjectFilePaths().push_back( objectPath );
+	}
+
+	// the ORC JIT links the objects into the app itself, against the app's symbols
+	if( settings.isOrcJitEnabled() ) {
+		result->getObjectFilePaths().insert( result->getObjectFilePaths().end(), settings.mObjPaths.begin(), settings.mObjPaths.end() );
+		return graph;
+	}
+
+	// and the link starts as soon as the last object is ready
+	auto numModuleObjects = result->getObjectFilePaths().size() + settings.mObjPaths.size();
+	auto linkerCommand = generateLinkerCommand( sourcePath, settings, result );
+	auto linkJob = graph.addJob( result->getOutputPath().filename().string(), linkerCommand, objectJobs );
+
+	// with only the app objects its own objects need
+	const auto &objects = result->getObjectFilePaths();
+	if( settings.mUseSymbolIndex && objects.size() > numModuleObjects ) {
+		std::vector<fs::path> moduleObjects( objects.begin(), objects.begin() + numModuleObjects );
+		std::vector<fs::path> appObjects( objects.begin() + numModuleObjects, objects.end() );
+		auto responsePath = getAppObjectsResponsePath( settings );
+		auto indexPath = settings.getIntermediatePath() / "runtime" / "symbols.idx";
+		bool verbose = settings.isVerboseEnabled();
+		graph.setStartHandler( linkJob, [=]() {
+			writeAppObjectsResponseFile( responsePath, indexPath, moduleObjects, appObjects, verbose );
+		} );
+	}
+
+	if( settings.isVerboseEnabled() ) {
+		CI_LOG_I( "linker command:\n" << linkerCommand );
+	}
+
+	return graph;
+}
+
+void CompilerGcc::build( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::function<void(const CompilationResult&)> &onBuildFinish )
+{
+	if( mWorkers.empty() ) {
+		throw CompilerException( "Compiler Process not initialized" );
+	}
+
+	// a newer save of the same module supersedes the build pending or running for it
+	auto buildName = settings.getModuleName().empty() ? sourcePath.generic_string() : settings.getModuleName();
+	cancel( buildName );
+
+	// prepare compilation results
+	CompilationResult result;
+	result.getFilePaths().push_back( sourcePath );
+
+	auto buildDir = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build";
+	if( ! fs::exists( buildDir ) ) {
+		fs::create_directories( buildDir );
+	}
+
+	// generate factor if needed and add it to the compiler list
+	auto buildSettings = settings;
+	if( settings.mGenerateFactory ) {
+		auto factoryPath = buildDir.parent_path() / ( settings.getModuleName() + "Factory.cpp" );
+		// rewritten when the declaration of the class changes, the object cache provides it otherwise
+		auto headerPath = sourcePath.parent_path() / ( settings.getModuleName() + ".h" );
+		generateClassFactory( factoryPath, settings.getTypeName(), headerPath );
+		buildSettings.additionalSource( factoryPath );
+	}
+
+	// header units replace the precompiled header, clang can't import them in place of the includes
+	if( ! buildSettings.mHeaderUnits.empty() && mIsClang ) {
+		CI_LOG_W( "Clang doesn't translate includes to header unit imports, using a precompiled header instead" );
+		buildSettings.mHeaderUnits.clear();
+	}
+	if( ! buildSettings.mHeaderUnits.empty() ) {
+		requireCpp20( &buildSettings.mCompilerOptions );
+	}
+
+	// issue the build jobs, the callback runs once the link succeeded
+	string pchFlags;
+	PrecompiledHeaderPool::Entry pchEntry;
+	std::vector<std::string> pchBuildNames;
+	// cached objects are compiled from the preprocessed sources, only the modules without the cache use a precompiled header or header units
+	if( ! buildSettings.mUseObjectCache ) {
+		pchBuildNames = queueHeaderUnits( buildSettings, &pchFlags );
+		if( pchBuildNames.empty() ) {
+			auto pchBuildName = queuePrecompiledHeader( sourcePath, buildSettings, &pchFlags, &pchEntry );
+			if( ! pchBuildName.empty() ) {
+				pchBuildNames.push_back( pchBuildName );
+			}
+		}
+	}
+	auto graph = generateBuildGraph( sourcePath, buildSettings, pchBuildNames, pchFlags, &result );
+
+	// without the object cache the compile jobs list the includes, except the ones the precompiled header is made of
+	auto buildFinished = onBuildFinish;
+	if( ! buildSettings.mUseObjectCache && ! pchEntry.key.empty() && onBuildFinish ) {
+		PrecompiledHeaderPool pool( buildSettings.getIntermediatePath() / "runtime" / "pch" );
+		buildFinished = [pool,pchEntry,onBuildFinish]( const CompilationResult &buildResult ) {
+			CompilationResult moduleResult = buildResult;
+			auto &dependencies = moduleResult.getDependencies();
+			auto pchDependencies = pool.getDependencies( pchEntry );
+			dependencies.insert( dependencies.end(), pchDependencies.begin(), pchDependencies.end() );
+			std::sort( dependencies.begin(), dependencies.end() );
+			dependencies.erase( std::unique( dependencies.begin(), dependencies.end() ), dependencies.end() );
+			onBuildFinish( moduleResult );
+		};
+	}
+	queueBuild( buildName, graph, result, buildFinished );
+}
+
+void CompilerGcc::build( const std::vector<ci::fs::path> &sourcesPaths, const BuildSettings &settings, const std::function<void( const CompilationResult& )> &onBuildFinish )
+{
+	if( sourcesPaths.size() > 1 ) {
+		BuildSettings buildSettings = settings;
+		for( size_t i = 1; i < sourcesPaths.size(); ++i ) {
+			buildSettings.additionalSource( sourcesPaths[i] );
+		}
+		build( sourcesPaths.front(), buildSettings, onBuildFinish );
+	}
+	else if( sourcesPaths.size() > 0 ) {
+		build( sourcesPaths.front(), settings, onBuildFinish );
+	}
+}
+
+void CompilerGcc::parseLine( Worker &worker, std::string_view line )
+{
+	// "<one dot per nesting level> <path>", printed by -H
+	size_t depth = 0;
+	while( depth < line.size() && line[depth] == '.' ) ++depth;
+	if( depth > 0 && depth < line.size() && line[depth] == ' ' ) {
+		fs::path header( line.substr( depth + 1 ) );
+		if( header.is_relative() ) {
+			header = getCLInitPath() / header;
+		}
+		// headers installed next to the compiler or in the system prefix aren't edited
+		static const string compilerPrefix = [this]() {
+			auto prefix = getCompilerPath().parent_path().parent_path();
+			return prefix.empty() || prefix == prefix.root_path() ? string( "/usr/" ) : prefix.generic_string() + "/";
+		}();
+		auto headerPath = header.lexically_normal().generic_string();
+		if( headerPath.compare( 0, 5, "/usr/" ) != 0 && headerPath.compare( 0, compilerPrefix.size(), compilerPrefix ) != 0 ) {
+			worker.dependencies.push_back( headerPath );
+		}
+		return;
+	}
+	// -H marks the precompiled header with "! " (or "x " when it can't be used) and ends with the headers that could use include guards, a bare path like ".../system_error" isn't a diagnostic
+	if( line.compare( 0, 2, "! " ) == 0 || line.compare( 0, 2, "x " ) == 0 || line == "Multiple include guards may be useful for:" || ( line.find( ": " ) == string_view::npos && fs::path( line ).is_absolute() ) ) {
+		return;
+	}
+	CompilerBase::parseLine( worker, line );
+}
+
+std::string CompilerGcc::formatDiagnostic( std::string_view line ) const
+{
+	return trimProjectDir( line );
+}
+
+std::string CompilerGcc::getBuildDescription() const
+{
+	return "Project: " + getProjectConfiguration().projectName + ", Configuration: " + getProjectConfiguration().configuration + " " + getProjectConfiguration().platform;
+}
+
+} // namespace runtime
+
+#endif // ! defined( CINDER_MSW )
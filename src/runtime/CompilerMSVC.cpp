@@ -1,13 +1,23 @@
+#include "cinder/Cinder.h"
+
+#if defined( CINDER_MSW )
+
 #include "runtime/CompilerMsvc.h"
+#include "runtime/BuildArtifacts.h"
 #include "runtime/ClassFactory.h"
+#include "runtime/ObjectCache.h"
 #include "runtime/PrecompiledHeader.h"
 #include "runtime/Process.h"
+#include "runtime/SymbolIndex.h"
+#include "runtime/UnityBuild.h"
 
 #include "cinder/app/App.h"
 #include "cinder/Xml.h"
 #include "cinder/Log.h"
 #include "cinder/Utilities.h"
 
+#include <algorithm>
+
 #define RT_VERBOSE_DEFAULT 0
 
 using namespace std;
@@ -261,15 +271,37 @@ namespace {
 			parseVcxproj( settings, *child, config, matched );
 		}
 	}
+
+	//! Writes the app objects needed by the module's objects to responsePath, or every app object if the module's objects can't be indexed
+	void writeAppObjectsResponseFile( const fs::path &responsePath, const fs::path &indexPath, const std::vector<fs::path> &moduleObjects, const std::vector<fs::path> &appObjects, bool verbose )
+	{
+		auto &symbolIndex = SymbolIndex::instance();
+		symbolIndex.load( indexPath );
+		std::vector<fs::path> neededObjects;
+		if( ! symbolIndex.getLinkClosure( moduleObjects, appObjects, &neededObjects ) ) {
+			neededObjects = appObjects;
+		}
+		symbolIndex.save();
+
+		if( verbose ) {
+			CI_LOG_I( "linking " << neededObjects.size() << " of " << appObjects.size() << " app objects" );
+		}
+
+		std::ofstream responseFile( responsePath );
+		for( const auto &obj : neededObjects ) {
+			responseFile << "\"" << obj.string() << "\"" << endl;
+		}
+	}
 }
 
-CompilerMsvc::BuildSettings::BuildSettings()
-: mVerbose( RT_VERBOSE_DEFAULT ), mLinkAppObjs( true ), mGenerateFactory( true ), mGeneratePch( false ), mUsePch( true ), mConfiguration( getProjectConfiguration().configuration ), mPlatform( getProjectConfiguration().platform ), mPlatformToolset( getProjectConfiguration().platformToolset )
+// the other constructors start from these defaults
+BuildSettings::BuildSettings()
+: mVerbose( RT_VERBOSE_DEFAULT ), mLinkAppObjs( true ), mLinkHostExports( false ), mGenerateFactory( true ), mGeneratePch( false ), mUsePch( true ), mUseObjectCache( true ), mUseSymbolIndex( true ), mUseOrcJit( false ), mUnitySize( 0 ), mConfiguration( getProjectConfiguration().configuration ), mPlatform( getProjectConfiguration().platform ), mPlatformToolset( getProjectConfiguration().platformToolset )
 {
 }
 
-CompilerMsvc::BuildSettings::BuildSettings( bool defaultSettings )
-: mVerbose( RT_VERBOSE_DEFAULT ), mLinkAppObjs( true ), mGenerateFactory( true ), mGeneratePch( false ), mUsePch( true ), mConfiguration( getProjectConfiguration().configuration ), mPlatform( getProjectConfiguration().platform ), mPlatformToolset( getProjectConfiguration().platformToolset )
+BuildSettings::BuildSettings( bool defaultSettings )
+: BuildSettings()
 {
 	compilerOption( "/nologo" ).compilerOption( "/W3" ).compilerOption( "/WX-" ).compilerOption( "/EHsc" ).compilerOption( "/RTC1" ).compilerOption( "/GS" )
 	.compilerOption( "/fp:precise" ).compilerOption( "/Zc:wchar_t" ).compilerOption( "/Zc:forScope" ).compilerOption( "/Zc:inline" ).compilerOption( "/Gd" ).compilerOption( "/TP" )
@@ -298,11 +330,11 @@ CompilerMsvc::BuildSettings::BuildSettings( bool defaultSettings )
 	}
 }
 
-CompilerMsvc::BuildSettings::BuildSettings( const ci::fs::path &vcxProjPath )
-: mVerbose( RT_VERBOSE_DEFAULT ), mLinkAppObjs( true ), mGenerateFactory( true ), mGeneratePch( false ), mUsePch( true ), mConfiguration( getProjectConfiguration().configuration ), mPlatform( getProjectConfiguration().platform ), mPlatformToolset( getProjectConfiguration().platformToolset )
+BuildSettings::BuildSettings( const ci::fs::path &projectPath )
+: BuildSettings()
 {
-	getProjectConfiguration().projectPath = vcxProjPath;
-	getProjectConfiguration().projectDir = vcxProjPath.parent_path();
+	getProjectConfiguration().projectPath = projectPath;
+	getProjectConfiguration().projectDir = projectPath.parent_path();
 	
 	compilerOption( "/nologo" ).compilerOption( "/W3" ).compilerOption( "/WX-" ).compilerOption( "/EHsc" ).compilerOption( "/RTC1" ).compilerOption( "/GS" )
 	.compilerOption( "/fp:precise" ).compilerOption( "/Zc:wchar_t" ).compilerOption( "/Zc:forScope" ).compilerOption( "/Zc:inline" ).compilerOption( "/Gd" ).compilerOption( "/TP" )
@@ -326,21 +358,6 @@ CompilerMsvc::BuildSettings::BuildSettings( const ci::fs::path &vcxProjPath )
 	parseVcxproj( this, XmlTree( loadFile( getProjectConfiguration().projectPath ) ), getProjectConfiguration() );
 }
 
-// Examples: turns 'MyClass' into '??_7MyClass@@6B@', or 'a::b::MyClass' into '??_7MyClass@b@a@@6B@'
-// See docs in generateLinkerCommand()
-// See MS Doc "Decorated Names": https://msdn.microsoft.com/en-us/library/56h2zst2.aspx?f=255&MSPPError=-2147217396#Format
-std::string	CompilerMsvc::getSymbolForVTable( const std::string &typeName ) const
-{
-	auto parts = ci::split( typeName, "::" );
-	string decoratedName;
-	for( auto rIt = parts.rbegin(); rIt != parts.rend(); ++rIt ) {
-		if( ! rIt->empty() ) // handle leading "::" case, which results in any empty part
-			decoratedName += *rIt + "@";
-	}
-
-	return "??_7" + decoratedName + "@6B@";
-}
-
 std::string CompilerMsvc::printToString() const
 {
 	stringstream str;
@@ -353,7 +370,7 @@ std::string CompilerMsvc::printToString() const
 
 void CompilerMsvc::debugLog( BuildSettings *settings ) const
 {
-	CI_LOG_I( "Compiler Settings: " << Compiler::instance().printToString() );
+	CI_LOG_I( "Compiler Settings: " << CompilerMsvc::instance().printToString() );
 	CI_LOG_I( "ProjectConfiguration: " << getProjectConfiguration().printToString() );
 
 	if( settings ) {
@@ -361,198 +378,6 @@ void CompilerMsvc::debugLog( BuildSettings *settings ) const
 	}
 }
 
-std::string CompilerMsvc::BuildSettings::printToString() const
-{
-	stringstream str;
-
-	str << "link app objs: " << mLinkAppObjs << ", generate factory: " << mGenerateFactory << ", generate pch: " << mGeneratePch << ", use pch: " << mUsePch << "\n";
-	str << "precompiled header: " << mPrecompiledHeader << "\n";
-	str << "output path: " << mOutputPath << "\n";
-	str << "intermediate path: " << mIntermediatePath << "\n";
-	str << "pdb path: " << mPdbPath << "\n";
-	str << "module name: " << mModuleName << "\n";
-	str << "type name: " << mTypeName << "\n";
-	str << "includes:\n";
-	for( const auto &include : mIncludes ) {
-		str << "\t- " << include << "\n";
-	}
-	str << "library paths:\n";
-	for( const auto &path : mLibraryPaths ) {
-		str << "\t- " << path << "\n";
-	}
-	str << "libraries:\n";
-	for( const auto &lib : mLibraries ) {
-		str << "\t- " << lib << "\n";
-	}
-	str << "additional sources:\n";
-	for( const auto &src : mAdditionalSources ) {
-		str << "\t- " << src << "\n";
-	}
-	str << "forced includes:\n";
-	for( const auto &include : mForcedIncludes ) {
-		str << "\t- " << include << "\n";
-	}
-	str << "preprocessor definitions: ";
-	for( const auto &ppDefine : mPpDefinitions ) {
-		str << ppDefine << " ";
-	}
-	str << endl;
-	str << "compiler options: ";
-	for( const auto &flag : mCompilerOptions ) {
-		str << flag << " ";
-	}
-	str << endl;
-	str << "linker options: ";
-	for( const auto &flag : mLinkerOptions ) {
-		str << flag << " ";
-	}
-	str << endl;
-	str << "user macros:\n";
-	for( const auto &macro : mUserMacros ) {
-		str << "\t- " << macro.first << " = " << macro.second << "\n";
-	}
-	str << endl;
-
-	return str.str();
-}
-
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::include( const ci::fs::path &path )
-{
-	mIncludes.push_back( path );
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::libraryPath( const ci::fs::path &path )
-{
-	mLibraryPaths.push_back( path );
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::library( const std::string &library )
-{
-	mLibraries.push_back( library );
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::define( const std::string &definition )
-{
-	mPpDefinitions.push_back( definition );
-	return *this;
-}
-
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::usePrecompiledHeader( bool use /*const ci::fs::path &path*/ )
-{
-	mUsePch = use;
-	//mPrecompiledHeader = path;
-	return *this;
-}
-		
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::createPrecompiledHeader( bool create /*const ci::fs::path &path*/ )
-{
-	mGeneratePch = create;
-	//mPrecompiledHeader = path;
-	return *this;
-}
-
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::objectFile( const ci::fs::path &path )
-{
-	mObjectFilePath = path;
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::programDatabase( const ci::fs::path &path )
-{
-	mPdbPath = path;
-	return *this;
-}
-
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::compilerOption( const std::string &option )
-{
-	mCompilerOptions.push_back( option );
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::linkerOption( const std::string &option )
-{
-	mLinkerOptions.push_back( option );
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::userMacro( const std::string &name, const std::string &value )
-{
-	mUserMacros[name] = value;
-	return *this;
-}
-
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::verbose( bool enabled )
-{
-	mVerbose = enabled;
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::outputPath( const ci::fs::path &path )
-{
-	mOutputPath = path;
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::intermediatePath( const ci::fs::path &path )
-{
-	mIntermediatePath = path;
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::configuration( const std::string &option )
-{
-	mConfiguration = option;
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::platform( const std::string &option )
-{
-	mPlatform = option;
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::platformToolset( const std::string &option )
-{
-	mPlatformToolset = option;
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::moduleName( const std::string &name )
-{
-	mModuleName = name;
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::typeName( const std::string &typeName )
-{ 
-	mTypeName = typeName;
-	return *this;
-}
-
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::forceInclude( const std::string &filename )
-{
-	mForcedIncludes.push_back( filename );
-	return *this;
-}
-
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::additionalSource( const ci::fs::path &cppFile )
-{
-	mAdditionalSources.push_back( cppFile );
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::additionalSources( const std::vector<ci::fs::path> &cppFiles )
-{
-	mAdditionalSources.insert( mAdditionalSources.begin(), cppFiles.begin(), cppFiles.end() );
-	return *this;
-}
-
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::linkObj( const ci::fs::path &path )
-{
-	mObjPaths.push_back( path );
-	return *this;
-}
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::linkAppObjs( bool link )
-{
-	mLinkAppObjs = link;
-	return *this;
-}
-
-CompilerMsvc::BuildSettings& CompilerMsvc::BuildSettings::generateFactory( bool generate )
-{
-	mGenerateFactory = generate;
-	return *this;
-}
-
 CompilerMsvc::CompilerMsvc()
 {
 	CI_LOG_V( "Tools / Options / Debugging / General / Enable Edit and Continue should be disabled! (And if file locking issues persist try enabling Use Native Compatibility Mode)" );
@@ -576,15 +401,15 @@ CompilerMsvc& CompilerMsvc::instance()
 
 void CompilerMsvc::build( const std::string &arguments, const std::function<void( const CompilationResult& )> &onBuildFinish )
 {
-	if( ! mProcess ) {
+	if( mWorkers.empty() ) {
 		throw CompilerException( "Compiler Process not initialized" );
 	}
-	// clear the error and warning vectors
-	mErrors.clear();
-	mWarnings.clear();
-		
-	// issue the build command with a completion token
-	mProcess << arguments << endl << "CI_BUILD_FINISHED" << endl;
+
+	// a build of a single job, named after its command so running it again supersedes the previous one
+	cancel( arguments );
+	BuildGraph graph;
+	graph.addJob( "", arguments );
+	queueBuild( arguments, graph, CompilationResult(), onBuildFinish );
 }
 
 std::string CompilerMsvc::getCLInitCommand() const
@@ -617,80 +442,159 @@ std::string CompilerMsvc::getCompilerInitArgs() const
 #endif
 }
 
-std::string CompilerMsvc::generateCompilerCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, CompilationResult* result ) const
+std::string CompilerMsvc::generateCompilerFlags( const BuildSettings &settings ) const
 {
-	string command;
-
-	// generate precompile header
-	if( settings.mUsePch ) {
-		
-		bool createPch = generatePrecompiledHeader( sourcePath, 
-			settings.getIntermediatePath() / "runtime" / settings.getModuleName() / ( settings.getModuleName() + "Pch.h" ),
-			settings.getIntermediatePath() / "runtime" / settings.getModuleName() / ( settings.getModuleName() + "Pch.cpp" ), false ) || settings.mGeneratePch;
+	string flags;
+	for( const auto &define : settings.mPpDefinitions ) {
+		flags += "/D " + define + " ";
+	}
+	for( const auto &include : settings.mIncludes ) {
+		flags += "/I" + include.generic_string() + " ";
+	}
+	for( const auto &include : settings.mForcedIncludes ) {
+		flags += "/FI" + include + " ";
+	}
+	for( const auto &compilerArg : settings.mCompilerOptions ) {
+		// cached objects outlive the module pdb, they have to carry their own debug information
+		// and so do objects sharing a precompiled header with other modules
+		if( ( settings.mUseObjectCache || settings.mUsePch ) && ( compilerArg == "/Zi" || compilerArg == "/ZI" ) ) {
+			flags += "/Z7 ";
+			continue;
+		}
+		flags += compilerArg + " ";
+	}
+#if defined( _DEBUG )
+	// translation units compile concurrently and share the same pdb
+	flags += "/FS ";
+#endif
+	return flags;
+}
 
-		if( createPch ) {
-			command += "cl /c ";
+std::string CompilerMsvc::generatePrecompiledHeaderCommand( const PrecompiledHeaderPool::Entry &entry, const ci::fs::path &sourceDir, const BuildSettings &settings ) const
+{
+	// the headers it includes are listed so the entry is only rebuilt when one of them changes
+	string command = "cl /c /showIncludes ";
+	command += generateCompilerFlags( settings );
+	// quoted includes of the pool header are looked up in the directory of the sources it was extracted from
+	command += "/I" + sourceDir.generic_string() + " ";
+	command += "/Fo" + ( entry.directory / "Pch.obj" ).string() + " ";
+	command += "/Fp" + ( entry.directory / "Pch.pch" ).string() + " ";
+	command += "/Yc" + entry.header.generic_string() + " ";
+	command += entry.source.generic_string();
 
-			for( const auto &define : settings.mPpDefinitions ) {
-				command += "/D " + define + " ";
-			}
-			for( const auto &include : settings.mIncludes ) {
-				command += "/I" + include.generic_string() + " ";
-			}
-			for( const auto &include : settings.mForcedIncludes ) {
-				command += "/FI " + include + " ";
-			}
-			for( const auto &compilerArg : settings.mCompilerOptions ) {
-				command += compilerArg + " ";
-			}
-			
-			command += settings.mObjectFilePath.empty() ? "/Fo" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / "/" ).string() + " " : "/Fo" + settings.mObjectFilePath.generic_string() + " ";
-			command += "/Fp" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + ".pch" ) ).string() + " ";
-		#if defined( _DEBUG )
-			command += "/Fd" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / "/" ).string() + " ";
-		#endif
+	if( settings.isVerboseEnabled() ) {
+		CI_LOG_I( "command:\n" << command );
+	}
 
-			command += "/Yc" + settings.getModuleName() + "Pch.h ";
+	return command;
+}
 
-			command += ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / ( settings.getModuleName() + "Pch.cpp" ) ).generic_string();
-			command += "\n";
-		}
+std::string CompilerMsvc::queuePrecompiledHeader( const ci::fs::path &sourcePath, const BuildSettings &settings, std::string *pchFlags, CompilationResult* result, PrecompiledHeaderPool::Entry *pchEntry )
+{
+	pchFlags->clear();
+	if( ! settings.mUsePch ) {
+		return string();
 	}
 
-	command += "cl ";
-	command += "/MP ";
-	
-	for( const auto &define : settings.mPpDefinitions ) {
-		command += "/D " + define + " ";
+	// modules with the same includes and flags share the same precompiled header
+	PrecompiledHeaderPool pool( settings.getIntermediatePath() / "runtime" / "pch" );
+	PrecompiledHeaderPool::Entry entry;
+	auto sourceDir = sourcePath.parent_path();
+	if( ! pool.acquire( getPrecompiledHeaderIncludes( sourcePath ), generateCompilerFlags( settings ) + "/I" + sourceDir.generic_string(), &entry ) ) {
+		return string();
 	}
-	for( const auto &include : settings.mIncludes ) {
-		command += "/I" + include.generic_string() + " ";
+	*pchEntry = entry;
+
+	*pchFlags = "/Fp" + ( entry.directory / "Pch.pch" ).string() + " ";
+	*pchFlags += "/Yu" + entry.header.generic_string() + " ";
+	*pchFlags += "/FI" + entry.header.generic_string() + " ";
+	// its object holds the debug information of the code it precompiled and has to be linked in
+	result->getObjectFilePaths().push_back( entry.directory / "Pch.obj" );
+
+	// the first module needing it builds it, the others wait for that build
+	auto pchBuildName = "pch:" + entry.key;
+	auto pchPath = entry.directory / "Pch.pch";
+	if( ! isBuilding( pchBuildName ) && ( ! pool.isUpToDate( entry, pchPath ) || ! fs::exists( entry.directory / "Pch.obj" ) || settings.mGeneratePch ) ) {
+		pool.invalidate( entry );
+		BuildGraph graph;
+		graph.addJob( entry.source.filename().string(), generatePrecompiledHeaderCommand( entry, sourceDir, settings ) );
+		CompilationResult result;
+		result.getFilePaths().push_back( entry.source );
+		result.setOutputPath( pchPath );
+		queueBuild( pchBuildName, graph, result, [pool,entry]( const CompilationResult &pchResult ) {
+			pool.recordDependencies( entry, pchResult.getDependencies() );
+		} );
 	}
-	for( const auto &include : settings.mForcedIncludes ) {
-		command += "/FI" + include + " ";
+
+	return pchBuildName;
+}
+
+std::string CompilerMsvc::generateHeaderUnitCommand( const PrecompiledHeaderPool::Entry &entry, const BuildSettings &settings ) const
+{
+	// the headers it includes are listed so the unit is only rebuilt when one of them changes
+	string command = "cl /c /nologo /showIncludes ";
+	command += generateCompilerFlags( settings );
+	command += "/exportHeader /headerName:angle " + entry.header.generic_string() + " ";
+	command += "/ifcOutput " + ( entry.directory / "HeaderUnit.ifc" ).string() + " ";
+	command += "/Fo" + ( entry.directory / "HeaderUnit.obj" ).string();
+
+	if( settings.isVerboseEnabled() ) {
+		CI_LOG_I( "command:\n" << command );
 	}
-	for( const auto &compilerArg : settings.mCompilerOptions ) {
-		command += compilerArg + " ";
+
+	return command;
+}
+
+std::vector<std::string> CompilerMsvc::queueHeaderUnits( const BuildSettings &settings, std::string *headerUnitFlags, CompilationResult* result )
+{
+	headerUnitFlags->clear();
+	std::vector<std::string> buildNames;
+	if( settings.mHeaderUnits.empty() ) {
+		return buildNames;
+	}
+
+	// the modules built with the same flags share the header units
+	PrecompiledHeaderPool pool( settings.getIntermediatePath() / "runtime" / "header-units" );
+	auto flags = generateCompilerFlags( settings );
+	*headerUnitFlags = "/translateInclude ";
+	for( const auto &header : settings.mHeaderUnits ) {
+		PrecompiledHeaderPool::Entry entry;
+		pool.acquireHeaderUnit( header, flags, &entry );
+		auto ifcPath = entry.directory / "HeaderUnit.ifc";
+		*headerUnitFlags += "/headerUnit:angle " + header + "=" + ifcPath.string() + " ";
+		// like a precompiled header, its object holds the code and debug information it compiled
+		result->getObjectFilePaths().push_back( entry.directory / "HeaderUnit.obj" );
+
+		auto buildName = "header-unit:" + entry.key;
+		if( ! isBuilding( buildName ) && ( ! pool.isUpToDate( entry, ifcPath ) || ! fs::exists( entry.directory / "HeaderUnit.obj" ) ) ) {
+			pool.invalidate( entry );
+			BuildGraph graph;
+			graph.addJob( header, generateHeaderUnitCommand( entry, settings ) );
+			CompilationResult headerUnitResult;
+			headerUnitResult.getFilePaths().push_back( header );
+			headerUnitResult.setOutputPath( ifcPath );
+			queueBuild( buildName, graph, headerUnitResult, [pool,entry]( const CompilationResult &headerUnitResult ) {
+				pool.recordDependencies( entry, headerUnitResult.getDependencies() );
+			} );
+		}
+		buildNames.push_back( buildName );
 	}
 
+	return buildNames;
+}
+
+std::string CompilerMsvc::generateCompilerCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::string &pchFlags ) const
+{
+	// the preprocessing job lists the includes when the object cache is used, otherwise the compiler does
+	string command = settings.mUseObjectCache ? "cl /c " : "cl /c /showIncludes ";
+	command += generateCompilerFlags( settings );
+
 	command += settings.mObjectFilePath.empty() ? "/Fo" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / "/" ).string() + " " : "/Fo" + settings.mObjectFilePath.generic_string() + " ";
 #if defined( _DEBUG )
 	command += settings.mPdbPath.empty() ? "/Fd" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / "/" ).string() + " " : "/Fd" + settings.mPdbPath.generic_string() + " ";
 #endif
-	
-	if( settings.mUsePch ) {
-		command += "/Fp" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + ".pch" ) ).string() + " ";
-		command += "/Yu" + settings.getModuleName() + "Pch.h ";
-		command += "/FI" + settings.getModuleName() + "Pch.h ";
-	}
-
-	// main source file
-	command += sourcePath.generic_string() + " ";
-	// additional files to compile
-	for( const auto &path : settings.mAdditionalSources ) {
-		command += path.generic_string() + " ";
-		result->getFilePaths().push_back( path );
-	}
+	command += pchFlags;
+	command += sourcePath.generic_string();
 
 	if( settings.isVerboseEnabled() ) {
 		CI_LOG_I( "command:\n" << command );
@@ -698,9 +602,22 @@ std::string CompilerMsvc::generateCompilerCommand( const ci::fs::path &sourcePat
 
 	return command;
 }
+
+namespace {
+	//! Returns the pdb of the module, named after the version being linked ("Foo.3.pdb" for "Foo.3.dll") so the debugger never holds the one the linker writes
+	fs::path getPdbPath( const BuildSettings &settings )
+	{
+		if( ! settings.getPdbPath().empty() ) {
+			return settings.getPdbPath();
+		}
+		auto outputPath = settings.getOutputPath().empty() ? ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + ".dll" ) ) : settings.getOutputPath();
+		return outputPath.parent_path() / ( outputPath.stem().string() + ".pdb" );
+	}
+} // anonymous namespace
+
 std::string CompilerMsvc::generateLinkerCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, CompilationResult* result ) const
 {
-	string command = "/link ";
+	string command = "link /nologo ";
 	
 	for( const auto &libraryPath : settings.mLibraryPaths ) {
 		command += "/LIBPATH:" + libraryPath.generic_string() + " ";
@@ -712,99 +629,191 @@ std::string CompilerMsvc::generateLinkerCommand( const ci::fs::path &sourcePath,
 		command += linkerArg + " ";
 	}
 	
-	// TODO: Make this optional
-	// vtable symbol export
-	// https://social.msdn.microsoft.com/Forums/vstudio/en-US/0cb15e28-4852-4cba-b63d-8a0de6e88d5f/accessing-the-vftable-vfptr-without-constructing-the-object?forum=vclanguage
-	// https://www.gamedev.net/forums/topic/392971-c-compile-time-retrival-of-a-classs-vtable-solved/?page=2
-	// https://www.gamedev.net/forums/topic/460569-c-compile-time-retrival-of-a-classs-vtable-solution-2/
-	if( ! fs::exists( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / ( settings.getModuleName() + ".def" ) ) ) {
-		// create a .def file with the symbol of the vtable to be able to find it with GetProcAddress	
-		std::ofstream outputFile( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / ( settings.getModuleName() + ".def" ) );		
-		outputFile << "EXPORTS" << endl;
-		outputFile << "\t" << getSymbolForVTable( settings.getTypeName() ) << "\t\tDATA" << endl;
-	}
-	command += "/DEF:" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / ( settings.getModuleName() + ".def" ) ).string() + " ";
-	
 	auto outputPath = settings.mOutputPath.empty() ? ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + ".dll" ) ) : settings.mOutputPath;
 	result->setOutputPath( outputPath );
 	command += "/OUT:" + outputPath.string() + " ";
 #if defined( _DEBUG )
 	command += "/DEBUG:FASTLINK ";
-	command += settings.mPdbPath.empty() ? "/PDB:" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + ".pdb" ) ).string() + " " : "/PDB:" + settings.mPdbPath.generic_string() + " ";
-	command += settings.mPdbPath.empty() ? "/PDBALTPATH:" + ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + ".pdb" ) ).string() + " " : "/PDBALTPATH:" + settings.mPdbPath.generic_string() + " ";
+	auto pdbPath = getPdbPath( settings );
+	command += "/PDB:" + pdbPath.string() + " ";
+	command += "/PDBALTPATH:" + pdbPath.string() + " ";
 #endif
 	command += "/INCREMENTAL ";
 	command += "/DLL ";
 
-	result->getObjectFilePaths().push_back( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + ".obj" ) );
+	// objects of the translation units compiled by the other jobs
+	for( const auto &obj : result->getObjectFilePaths() ) {
+		command += obj.generic_string() + " ";
+	}
 	for( const auto &obj : settings.mObjPaths ) {
 		command += obj.generic_string() + " ";
 		result->getObjectFilePaths().push_back( obj );
 	}
-	
-	command += ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + "Pch.obj" ) ).generic_string() + " ";
 
-	if( settings.mGenerateFactory ) { 
-		command += ( settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + "Factory.obj" ) ).generic_string() + " ";
+	// the app exports its symbols once and the module resolves them through its import library
+	bool linkAppObjs = settings.mLinkAppObjs;
+	if( settings.mLinkHostExports ) {
+		auto importLibrary = settings.mHostImportLibrary.empty() ? app::getAppPath() / ( getProjectConfiguration().projectPath.stem().string() + ".lib" ) : settings.mHostImportLibrary;
+		if( fs::exists( importLibrary ) ) {
+			command += importLibrary.generic_string() + " ";
+			linkAppObjs = false;
+		}
+		else {
+			CI_LOG_W( "Host import library not found at " << importLibrary << ", linking the app objects instead" );
+		}
 	}
 
-	if( settings.mLinkAppObjs ) {
+	if( linkAppObjs ) {
+		std::vector<fs::path> appObjects;
 		for( auto it = fs::directory_iterator( settings.getIntermediatePath() ), end = fs::directory_iterator(); it != end; it++ ) {
 			if( it->path().extension() == ".obj" ) {
 				// Skip obj for current source and current app
 				if( it->path().filename().string().find( settings.getModuleName() + ".obj" ) == string::npos 
 					&& it->path().filename().string().find( getProjectConfiguration().projectPath.stem().string() + "App.obj" ) == string::npos
 					) {
-					command += it->path().generic_string() + " ";
-					result->getObjectFilePaths().push_back( it->path() );
+					appObjects.push_back( it->path() );
 				}
 			}
 		}
+		// the objects the module needs are only known once its own objects are compiled, the link job lists them right before starting
+		if( settings.mUseSymbolIndex && ! appObjects.empty() ) {
+			command += "@" + getAppObjectsResponsePath( settings ).string() + " ";
+		}
+		else {
+			for( const auto &obj : appObjects ) {
+				command += obj.generic_string() + " ";
+			}
+		}
+		result->getObjectFilePaths().insert( result->getObjectFilePaths().end(), appObjects.begin(), appObjects.end() );
 	}
 
 	return command;
 }
 
-std::string CompilerMsvc::generateBuildCommand( const ci::fs::path &sourcePath, const BuildSettings &settings, CompilationResult* result ) const
+ci::fs::path CompilerMsvc::getAppObjectsResponsePath( const BuildSettings &settings ) const
 {
-	auto compilerCommand = generateCompilerCommand( sourcePath, settings, result );
+	return settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build" / ( settings.getModuleName() + "AppObjs.rsp" );
+}
+
+std::string CompilerMsvc::generatePreprocessorCommand( const ci::fs::path &sourcePath, const ci::fs::path &preprocessedPath, const BuildSettings &settings ) const
+{
+	string command = "cl /nologo /P /showIncludes ";
+	command += generateCompilerFlags( settings );
+	command += "/Fi" + preprocessedPath.string() + " ";
+	command += sourcePath.generic_string();
+	return command;
+}
+
+std::string CompilerMsvc::generatePreprocessedCompilerArguments( const std::string &inputPath, const std::string &outputPath, const BuildSettings &settings ) const
+{
+	// the preprocessed source needs neither the includes nor the definitions, and the agent's pdb wouldn't be reachable
+	string arguments = "/c /nologo ";
+	for( const auto &compilerArg : settings.mCompilerOptions ) {
+		arguments += ( compilerArg == "/Zi" || compilerArg == "/ZI" ? "/Z7" : compilerArg ) + " ";
+	}
+	return arguments + "/Fo" + outputPath + " /Tp" + inputPath;
+}
+
+BuildGraph CompilerMsvc::generateBuildGraph( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::vector<std::string> &pchBuildNames, const std::string &pchFlags, CompilationResult* result ) const
+{
+	BuildGraph graph;
+
+	// every translation unit waits for the builds of the shared precompiled header or header units that are running
+	std::vector<size_t> pchJob;
+	for( const auto &pchBuildName : pchBuildNames ) {
+		pchJob.push_back( graph.addExternalJob( pchBuildName ) );
+	}
+
+	// then they compile concurrently on separate workers, unless the cache has an object for the same preprocessed source
+	auto buildDir = settings.getIntermediatePath() / "runtime" / settings.getModuleName() / "build";
+	auto objectDir = settings.mObjectFilePath.empty() ? buildDir : settings.mObjectFilePath;
+	ObjectCache objectCache( settings.getIntermediatePath() / "runtime" / "cache" );
+	std::vector<fs::path> sources = { sourcePath };
+	sources.insert( sources.end(), settings.mAdditionalSources.begin(), settings.mAdditionalSources.end() );
+	result->getFilePaths().insert( result->getFilePaths().end(), sources.begin() + 1, sources.end() );
+	// a unity build compiles groups of sources as a single translation unit, the precompiled header and the cache work the same on them
+	auto translationUnits = settings.mUnitySize ? generateUnitySources( sources, settings.mUnityExclusions, settings.mUnitySize, buildDir.parent_path(), settings.getModuleName() ) : sources;
+	auto remoteArguments = generatePreprocessedCompilerArguments( "{input}", "{output}", settings );
+	std::vector<size_t> objectJobs;
+	for( size_t i = 0; i < translationUnits.size(); ++i ) {
+		auto objectPath = objectDir / ( translationUnits[i].stem().string() + ".obj" );
+		if( settings.mUseObjectCache ) {
+			// the preprocessor also lists the headers the module depends on
+			auto preprocessedPath = buildDir / ( translationUnits[i].stem().string() + ".i" );
+			auto preprocessorCommand = generatePreprocessorCommand( translationUnits[i], preprocessedPath, settings );
+			// the object is compiled from the preprocessed source the cache key is computed from, a source edited in the meantime can't be stored under that key
+			auto cachedCompilerCommand = "cl " + generatePreprocessedCompilerArguments( preprocessedPath.string(), objectPath.string(), settings );
+			objectJobs.push_back( objectCache.addCompileJobs( &graph, translationUnits[i].filename().string(), preprocessorCommand, preprocessedPath, cachedCompilerCommand, objectPath, pchJob ) );
+			// a cache miss can compile on a build agent, the preprocessed source is all it needs
+			graph.setRemoteCompile( objectJobs.back(), { remoteArguments, preprocessedPath.string(), objectPath.string() } );
+		}
+		else {
+			objectJobs.push_back( graph.addJob( translationUnits[i].filename().string(), generateCompilerCommand( translationUnits[i], settings, pchFlags ), pchJob ) );
+		}
+		result->getObjectFilePaths().push_back( objectPath );
+	}
+
+	// the ORC JIT links the objects into the app itself, against the app's symbols
+	if( settings.isOrcJitEnabled() ) {
+		result->getObjectFilePaths().insert( result->getObjectFilePaths().end(), settings.mObjPaths.begin(), settings.mObjPaths.end() );
+		return graph;
+	}
+
+	// and the link starts as soon as the last object is ready
+	auto numModuleObjects = result->getObjectFilePaths().size() + settings.mObjPaths.size();
 	auto linkerCommand = generateLinkerCommand( sourcePath, settings, result );
+	auto linkJob = graph.addJob( result->getOutputPath().filename().string(), linkerCommand, objectJobs );
+
+	// with only the app objects its own objects need
+	const auto &objects = result->getObjectFilePaths();
+	if( settings.mUseSymbolIndex && objects.size() > numModuleObjects ) {
+		std::vector<fs::path> moduleObjects( objects.begin(), objects.begin() + numModuleObjects );
+		std::vector<fs::path> appObjects( objects.begin() + numModuleObjects, objects.end() );
+		auto responsePath = getAppObjectsResponsePath( settings );
+		auto indexPath = settings.getIntermediatePath() / "runtime" / "symbols.idx";
+		bool verbose = settings.isVerboseEnabled();
+		graph.setStartHandler( linkJob, [=]() {
+			writeAppObjectsResponseFile( responsePath, indexPath, moduleObjects, appObjects, verbose );
+		} );
+	}
 
 	if( settings.isVerboseEnabled() ) {
-		CI_LOG_I( "compiler command:\n" << compilerCommand );
 		CI_LOG_I( "linker command:\n" << linkerCommand );
 	}
 
-	return compilerCommand + linkerCommand;
+	return graph;
 }
 
 namespace {
-	fs::path getNextAvailableName( const ci::fs::path &path ) 
+	//! Replaces the language standard of options by C++20 when it is older or missing, header units need it
+	void requireCpp20( std::vector<std::string> *options )
 	{
-		auto parent = path.parent_path();
-		auto stem = path.stem().string();
-		auto ext = path.extension().string();
-		uint16_t count = 0;
-		while( fs::exists( parent / ( stem + "_" + to_string( count ) + ext ) ) ){
-			count++;
+		for( auto it = options->begin(); it != options->end(); ) {
+			if( it->compare( 1, 5, "std:c" ) == 0 ) {
+				if( *it == "/std:c++20" || *it == "/std:c++latest" || *it == "-std:c++20" || *it == "-std:c++latest" ) {
+					return;
+				}
+				it = options->erase( it );
+			}
+			else {
+				++it;
+			}
 		}
-		return parent / ( stem + "_" + to_string( count ) + ext );
+		options->push_back( "/std:c++20" );
 	}
 } // anonymous namespace
 
 
 void CompilerMsvc::build( const ci::fs::path &sourcePath, const BuildSettings &settings, const std::function<void(const CompilationResult&)> &onBuildFinish )
 {
-	if( ! mProcess ) {
+	if( mWorkers.empty() ) {
 		throw CompilerException( "Compiler Process not initialized" );
 	}
-	
-    std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
-
-	// clear the error and warning vectors
-	mErrors.clear();
-	mWarnings.clear();
 
+	// a newer save of the same module supersedes the build pending or running for it
+	auto buildName = settings.getModuleName().empty() ? sourcePath.generic_string() : settings.getModuleName();
+	cancel( buildName );
+	
 	// prepare compilation results
 	CompilationResult result;
 	result.getFilePaths().push_back( sourcePath );
@@ -815,10 +824,10 @@ void CompilerMsvc::build( const ci::fs::path &sourcePath, const BuildSettings &s
 	}
 
 #if defined( _DEBUG ) && 1
-	// try renaming previous pdb files to prevent errors
-	auto pdb = settings.mPdbPath.empty() ? ( buildDir / ( settings.getModuleName() + ".pdb" ) ) : settings.mPdbPath;
+	// each version of a module has its own pdb, one written by an earlier build is renamed since the debugger might hold it
+	auto pdb = getPdbPath( settings );
 	if( fs::exists( pdb ) ) {
-		auto newName = getNextAvailableName( pdb );
+		auto newName = BuildArtifacts::instance().getNextName( pdb );
 		try {
 			fs::rename( pdb, newName );
 		} catch( const std::exception & ) {}
@@ -830,25 +839,48 @@ void CompilerMsvc::build( const ci::fs::path &sourcePath, const BuildSettings &s
 	auto buildSettings = settings;
 	if( settings.mGenerateFactory ) {
 		auto factoryPath = buildDir.parent_path() / ( settings.getModuleName() + "Factory.cpp" );
-		if( ! fs::exists( factoryPath ) ) {
-			string headerName = settings.getModuleName() + ".h";
-			generateClassFactory( factoryPath, settings.getTypeName(), headerName );
-		}
-		auto factoryObjPath = buildDir / ( settings.getModuleName() + "Factory.obj" );
-		//if( ! fs::exists( factoryObjPath ) ) {
-			buildSettings.additionalSource( factoryPath );
-		//}
-		//else {
-		//	buildSettings.linkObj( factoryObjPath );
-		//}
+		// rewritten when the declaration of the class changes, the object cache provides it otherwise
+		auto headerPath = sourcePath.parent_path() / ( settings.getModuleName() + ".h" );
+		generateClassFactory( factoryPath, settings.getTypeName(), headerPath );
+		buildSettings.additionalSource( factoryPath );
 	}
 		
-	// issue the build command with a completion token
-	auto command = generateBuildCommand( sourcePath, buildSettings, &result );
-	mBuilds.insert( make_pair( sourcePath.filename(), make_tuple( result, onBuildFinish, timePoint ) ) );
-	app::console() << endl << "1>------ Runtime Compiler Build started: Project: " << getProjectConfiguration().projectPath.stem() << ", Configuration: " << getProjectConfiguration().configuration << " " << getProjectConfiguration().platform << " ------" << endl;
-	app::console() << "1>  " << sourcePath.filename() << endl;
-	mProcess << command << endl << ( "CI_BUILD " + sourcePath.filename().string() ) << endl;
+	// header units replace the precompiled header
+	if( ! buildSettings.mHeaderUnits.empty() ) {
+		requireCpp20( &buildSettings.mCompilerOptions );
+	}
+
+	// issue the build jobs, the callback runs once the link succeeded
+	string pchFlags;
+	PrecompiledHeaderPool::Entry pchEntry;
+	std::vector<std::string> pchBuildNames;
+	// cached objects are compiled from the preprocessed sources, only the modules without the cache use a precompiled header or header units
+	if( ! buildSettings.mUseObjectCache ) {
+		pchBuildNames = queueHeaderUnits( buildSettings, &pchFlags, &result );
+		if( pchBuildNames.empty() ) {
+			auto pchBuildName = queuePrecompiledHeader( sourcePath, buildSettings, &pchFlags, &result, &pchEntry );
+			if( ! pchBuildName.empty() ) {
+				pchBuildNames.push_back( pchBuildName );
+			}
+		}
+	}
+	auto graph = generateBuildGraph( sourcePath, buildSettings, pchBuildNames, pchFlags, &result );
+
+	// without the object cache the compile jobs list the includes, except the ones the precompiled header is made of
+	auto buildFinished = onBuildFinish;
+	if( ! buildSettings.mUseObjectCache && ! pchEntry.key.empty() && onBuildFinish ) {
+		PrecompiledHeaderPool pool( buildSettings.getIntermediatePath() / "runtime" / "pch" );
+		buildFinished = [pool,pchEntry,onBuildFinish]( const CompilationResult &buildResult ) {
+			CompilationResult moduleResult = buildResult;
+			auto &dependencies = moduleResult.getDependencies();
+			auto pchDependencies = pool.getDependencies( pchEntry );
+			dependencies.insert( dependencies.end(), pchDependencies.begin(), pchDependencies.end() );
+			std::sort( dependencies.begin(), dependencies.end() );
+			dependencies.erase( std::unique( dependencies.begin(), dependencies.end() ), dependencies.end() );
+			onBuildFinish( moduleResult );
+		};
+	}
+	queueBuild( buildName, graph, result, buildFinished );
 }
 
 void CompilerMsvc::build( const std::vector<ci::fs::path> &sourcesPaths, const BuildSettings &settings, const std::function<void( const CompilationResult& )> &onBuildFinish )
@@ -867,78 +899,66 @@ void CompilerMsvc::build( const std::vector<ci::fs::path> &sourcesPaths, const B
 
 
 namespace {
-	inline std::string removeEndline( const std::string &input ) 
-	{ 
-		auto output = input;
-		while( output.size() && ( output.back() == '\n' ) ) output = output.substr( 0, output.length() - 1 );
-		return output;
-	}
-}
-
-namespace {
-std::string trimProjectDir( const std::string &s )
+std::string trimProjectDir( std::string_view s )
 {
-	auto it = s.find( getProjectConfiguration().projectDir.generic_string() );
+	auto projectDir = getProjectConfiguration().projectDir.generic_string();
+	auto it = s.find( projectDir );
 	if( it != std::string::npos ) {
-		return s.substr( getProjectConfiguration().projectDir.generic_string().length() );
+		return std::string( s.substr( projectDir.length() ) );
 	}
 	else {
-		return s;
+		return std::string( s );
 	}
 }
 }
 
-void CompilerMsvc::parseProcessOutput()
+std::string CompilerMsvc::getShellStatusVariable() const
 {
-	string fullOutput;
-	auto buildIt = mBuilds.end();
-	while( mProcess->isOutputAvailable() ) {
-		auto output = removeEndline( mProcess->getOutputAsync() );
-		if( output.find( "error" ) != string::npos ) { 
-			mErrors.push_back( trimProjectDir( output ) );	
-		}
-		else if( output.find( "warning" ) != string::npos ) {
-			mWarnings.push_back( trimProjectDir( output ) );
-		}
-		if( output.find( "CI_BUILD" ) != string::npos ) {
-			buildIt = mBuilds.find( output.substr( output.find_first_of( " " ) + 1 ) );
-		}
-		fullOutput += output;
+	return "%ERRORLEVEL%";
+}
+
+std::string CompilerMsvc::getShellFallbackCommand( const std::string &command, int status, const std::string &fallback ) const
+{
+	// "if errorlevel n" is true for any exit code from n
+	return command + " & if errorlevel " + to_string( status ) + " if not errorlevel " + to_string( status + 1 ) + " " + fallback;
+}
+
+namespace {
+	//! Returns whether header belongs to Visual Studio or to the Windows SDK
+	bool isSystemHeader( std::string_view header )
+	{
+		std::string path( header );
+		std::transform( path.begin(), path.end(), path.begin(), []( char c ) { return static_cast<char>( ::tolower( c ) ); } );
+		std::replace( path.begin(), path.end(), '/', '\\' );
+		return path.find( "\\microsoft visual studio" ) != string::npos || path.find( "\\windows kits\\" ) != string::npos;
 	}
-	
-	if( mVerbose && ! fullOutput.empty() ) app::console() << fullOutput << endl;
-	
-	if( buildIt != mBuilds.end() ) {
-		
-		for( auto warning : mWarnings ) {
-			app::console() << "1>" + warning << endl;
-		}	
-		if( mErrors.empty() ) {
-			const Build &build = buildIt->second;
-			app::console() << "1>  " << std::get<0>( build ).getFilePaths().front().filename() << " -> " << std::get<0>( build ).getOutputPath() << endl;
-			if( ! std::get<0>( build ).getPdbFilePath().empty() ) {
-				app::console() << "1>  " << std::get<0>( build ).getFilePaths().front().filename() << " -> " << std::get<0>( build ).getPdbFilePath() << endl;
-			}
-			app::console() << "========== Runtime Compiler Build: 1 succeeded, 0 failed, 0 up-to-date, 0 skipped ==========" << endl;
-			auto elapsed = std::chrono::steady_clock::now() - std::get<2>( build );
-			auto elapsedMicro = std::chrono::duration_cast<std::chrono::microseconds>( elapsed ).count();
-			auto elapsedMinutes = std::chrono::duration_cast<std::chrono::hours>( elapsed ).count();
-			auto elapsedHours = std::chrono::duration_cast<std::chrono::hours>( elapsed ).count();
-			std::ostringstream oss;
-			oss << std::setfill('0') << std::setw(2) << elapsedHours << ":" << std::setw(2) << elapsedMinutes << ":"
-				<< std::setw(2) << ( elapsedMicro % 1000000000 ) / 1000000 << "." << std::setw(3) << ( elapsedMicro % 1000000 ) / 1000;
-			app::console() << endl << "Time Elapsed " << oss.str() << endl << endl;
-			std::get<1>( build )( std::get<0>( build ) );
-		}
-		else {
-			for( auto error : mErrors ) {
-				app::console() << "1>" + error << endl;
-			}
-			app::console() << "========== Runtime Compiler Build: 0 succeeded, 1 failed, 0 up-to-date, 0 skipped ==========" << endl;
-		}
+} // anonymous namespace
 
-		mBuilds.erase( buildIt );
+void CompilerMsvc::parseLine( Worker &worker, std::string_view line )
+{
+	// "Note: including file: <one space per nesting level><path>", printed by /showIncludes
+	const std::string_view includePrefix = "Note: including file:";
+	if( line.substr( 0, includePrefix.size() ) == includePrefix ) {
+		auto header = line.substr( includePrefix.size() );
+		while( ! header.empty() && header.front() == ' ' ) header.remove_prefix( 1 );
+		if( ! header.empty() && ! isSystemHeader( header ) ) {
+			worker.dependencies.emplace_back( header );
+		}
+		return;
 	}
+	CompilerBase::parseLine( worker, line );
+}
+
+std::string CompilerMsvc::formatDiagnostic( std::string_view line ) const
+{
+	return trimProjectDir( line );
+}
+
+std::string CompilerMsvc::getBuildDescription() const
+{
+	return "Project: " + getProjectConfiguration().projectPath.stem().string() + ", Configuration: " + getProjectConfiguration().configuration + " " + getProjectConfiguration().platform;
+}
+
 }
 
-}
\ No newline at end of file
+#endif // defined( CINDER_MSW )
@@ -0,0 +1,120 @@
+#include "runtime/DependencyIndex.h"
+
+#include "cinder/FileWatcher.h"
+
+#include <fstream>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+DependencyIndex& DependencyIndex::instance()
+{
+	static DependencyIndex index;
+	return index;
+}
+
+void DependencyIndex::setDependencies( const std::string &moduleName, const std::vector<ci::fs::path> &headers, const ChangeFn &onChange )
+{
+	std::set<fs::path> newHeaders;
+	for( const auto &header : headers ) {
+		newHeaders.insert( header.lexically_normal() );
+	}
+
+	auto &module = mModules[moduleName];
+	module.onChange = onChange;
+
+	// forget the headers the module doesn't include anymore
+	for( const auto &header : module.headers ) {
+		if( ! newHeaders.count( header ) ) {
+			releaseHeader( header, moduleName );
+		}
+	}
+
+	// a header shared by several modules is watched once
+	for( const auto &header : newHeaders ) {
+		mDependentModules[header].insert( moduleName );
+		if( ! mWatches.count( header ) ) {
+			mWatches[header] = FileWatcher::instance().watch( header, FileWatcher::Options().callOnWatch( false ), [this, header]( const WatchEvent & ) {
+				onHeaderChanged( header );
+			} );
+		}
+	}
+	module.headers = std::move( newHeaders );
+}
+
+void DependencyIndex::removeModule( const std::string &moduleName )
+{
+	auto moduleIt = mModules.find( moduleName );
+	if( moduleIt != mModules.end() ) {
+		for( const auto &header : moduleIt->second.headers ) {
+			releaseHeader( header, moduleName );
+		}
+		mModules.erase( moduleIt );
+	}
+}
+
+void DependencyIndex::releaseHeader( const ci::fs::path &header, const std::string &moduleName )
+{
+	auto dependentsIt = mDependentModules.find( header );
+	if( dependentsIt != mDependentModules.end() ) {
+		dependentsIt->second.erase( moduleName );
+		if( dependentsIt->second.empty() ) {
+			mDependentModules.erase( dependentsIt );
+			mWatches.erase( header );
+		}
+	}
+}
+
+std::vector<ci::fs::path> DependencyIndex::getDependencies( const std::string &moduleName ) const
+{
+	auto moduleIt = mModules.find( moduleName );
+	if( moduleIt == mModules.end() ) {
+		return {};
+	}
+	return std::vector<fs::path>( moduleIt->second.headers.begin(), moduleIt->second.headers.end() );
+}
+
+std::vector<std::string> DependencyIndex::getDependentModules( const ci::fs::path &header ) const
+{
+	auto dependentsIt = mDependentModules.find( header.lexically_normal() );
+	if( dependentsIt == mDependentModules.end() ) {
+		return {};
+	}
+	return std::vector<std::string>( dependentsIt->second.begin(), dependentsIt->second.end() );
+}
+
+void DependencyIndex::onHeaderChanged( const ci::fs::path &header )
+{
+	// the callbacks can update the index, work on a copy
+	for( const auto &moduleName : getDependentModules( header ) ) {
+		auto moduleIt = mModules.find( moduleName );
+		if( moduleIt != mModules.end() && moduleIt->second.onChange ) {
+			auto onChange = moduleIt->second.onChange;
+			onChange( header );
+		}
+	}
+}
+
+void DependencyIndex::save( const std::string &moduleName, const ci::fs::path &path ) const
+{
+	std::ofstream file( path );
+	for( const auto &header : getDependencies( moduleName ) ) {
+		file << header.string() << endl;
+	}
+}
+
+std::vector<ci::fs::path> DependencyIndex::load( const ci::fs::path &path )
+{
+	std::vector<fs::path> headers;
+	std::ifstream file( path );
+	for( string line; std::getline( file, line ); ) {
+		if( ! line.empty() && fs::exists( line ) ) {
+			headers.push_back( line );
+		}
+	}
+	return headers;
+}
+
+} // namespace runtime
@@ -0,0 +1,94 @@
+#include "runtime/Epoch.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace runtime {
+
+thread_local std::shared_ptr<Epoch::ThreadState> Epoch::sThreadState;
+
+Epoch& Epoch::instance()
+{
+	static Epoch epoch;
+	return epoch;
+}
+
+Epoch::Epoch()
+: mEpoch( 1 ), mNumPending( 0 )
+{
+}
+
+void Epoch::registerThread()
+{
+	if( sThreadState ) {
+		return;
+	}
+
+	// the thread can't be running an old version yet, it starts in the current epoch
+	auto state = make_shared<ThreadState>();
+	state->epoch = mEpoch.load();
+	sThreadState = state;
+	lock_guard<mutex> lock( mMutex );
+	mThreads.push_back( state );
+}
+
+void Epoch::unregisterThread()
+{
+	if( ! sThreadState ) {
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock( mMutex );
+		mThreads.erase( std::remove( mThreads.begin(), mThreads.end(), sThreadState ), mThreads.end() );
+	}
+	sThreadState.reset();
+	reclaim();
+}
+
+void Epoch::quiescentState()
+{
+	if( auto state = sThreadState.get() ) {
+		state->epoch = mEpoch.load();
+		// the lock is only taken while a version waits to be released
+		if( mNumPending ) {
+			reclaim();
+		}
+	}
+}
+
+void Epoch::retire( const std::function<void()> &releaseFn )
+{
+	{
+		// the threads reporting a quiescent point from now on won't run the retired version again
+		lock_guard<mutex> lock( mMutex );
+		mRetired.push_back( { ++mEpoch, releaseFn } );
+		mNumPending = mRetired.size();
+	}
+	reclaim();
+}
+
+void Epoch::reclaim()
+{
+	std::vector<std::function<void()>> releaseFns;
+	{
+		lock_guard<mutex> lock( mMutex );
+		uint64_t oldest = mEpoch.load();
+		for( const auto &thread : mThreads ) {
+			oldest = std::min( oldest, thread->epoch.load() );
+		}
+		while( ! mRetired.empty() && mRetired.front().epoch <= oldest ) {
+			releaseFns.push_back( std::move( mRetired.front().releaseFn ) );
+			mRetired.pop_front();
+		}
+		mNumPending = mRetired.size();
+	}
+
+	// outside of the lock, a release function can retire something else
+	for( const auto &releaseFn : releaseFns ) {
+		releaseFn();
+	}
+}
+
+} // namespace runtime
@@ -0,0 +1,151 @@
+#include "runtime/LineBuffer.h"
+
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+namespace runtime {
+
+namespace {
+	inline std::string_view removeCarriageReturn( std::string_view line )
+	{
+		while( ! line.empty() && line.back() == '\r' ) line.remove_suffix( 1 );
+		return line;
+	}
+} // anonymous namespace
+
+LineBuffer::LineBuffer( size_t arenaSize )
+: mArena( std::max<size_t>( arenaSize, 2 ) ), mBegin( 0 ), mEnd( 0 ), mScanned( 0 ), mSplitLine( false )
+{
+}
+
+char* LineBuffer::prepare( size_t* size )
+{
+	// move the pending incomplete line back to the start of the arena to make room
+	if( mBegin > 0 ) {
+		std::memmove( mArena.data(), mArena.data() + mBegin, mEnd - mBegin );
+		mEnd -= mBegin;
+		mScanned -= mBegin;
+		mBegin = 0;
+	}
+	*size = mArena.size() - mEnd;
+	return mArena.data() + mEnd;
+}
+
+void LineBuffer::commit( size_t size, const LineFn &lineFn )
+{
+	mEnd += size;
+	while( mScanned < mEnd ) {
+		auto newLine = static_cast<const char*>( std::memchr( mArena.data() + mScanned, '\n', mEnd - mScanned ) );
+		if( ! newLine ) {
+			mScanned = mEnd;
+			break;
+		}
+		size_t lineEnd = static_cast<size_t>( newLine - mArena.data() );
+		// skip the empty remainder of a line that has already been handed out in pieces
+		if( ! mSplitLine || lineEnd != mBegin ) {
+			lineFn( removeCarriageReturn( std::string_view( mArena.data() + mBegin, lineEnd - mBegin ) ) );
+		}
+		mSplitLine = false;
+		mBegin = mScanned = lineEnd + 1;
+	}
+
+	// a line filling the whole arena is handed out in pieces
+	if( mBegin == 0 && mEnd == mArena.size() ) {
+		flush( lineFn );
+		mSplitLine = true;
+	}
+	// nothing pending, rewind for free
+	else if( mBegin == mEnd ) {
+		mBegin = mEnd = mScanned = 0;
+	}
+}
+
+void LineBuffer::append( const char* data, size_t size, const LineFn &lineFn )
+{
+	while( size ) {
+		size_t available;
+		char* destination = prepare( &available );
+		size_t count = std::min( size, available );
+		std::memcpy( destination, data, count );
+		commit( count, lineFn );
+		data += count;
+		size -= count;
+	}
+}
+
+void LineBuffer::flush( const LineFn &lineFn )
+{
+	if( mEnd > mBegin ) {
+		lineFn( removeCarriageReturn( std::string_view( mArena.data() + mBegin, mEnd - mBegin ) ) );
+	}
+	clear();
+}
+
+void LineBuffer::clear()
+{
+	mBegin = mEnd = mScanned = 0;
+	mSplitLine = false;
+}
+
+LineHistory::LineHistory( size_t capacity )
+: mData( std::max<size_t>( capacity, 1 ) ), mStart( 0 ), mSize( 0 ), mTruncated( false )
+{
+}
+
+void LineHistory::push( std::string_view line )
+{
+	pushBytes( line.data(), line.size() );
+	pushBytes( "\n", 1 );
+}
+
+void LineHistory::pushBytes( const char* data, size_t size )
+{
+	const size_t capacity = mData.size();
+	// only the tail of a chunk bigger than the whole history can be kept
+	if( size >= capacity ) {
+		std::memcpy( mData.data(), data + size - capacity, capacity );
+		mStart = 0;
+		mSize = capacity;
+		mTruncated = true;
+		return;
+	}
+	// drop the oldest bytes to make room
+	if( mSize + size > capacity ) {
+		size_t overflow = mSize + size - capacity;
+		mStart = ( mStart + overflow ) % capacity;
+		mSize -= overflow;
+		mTruncated = true;
+	}
+	size_t end = ( mStart + mSize ) % capacity;
+	size_t first = std::min( size, capacity - end );
+	std::memcpy( mData.data() + end, data, first );
+	std::memcpy( mData.data(), data + first, size - first );
+	mSize += size;
+}
+
+std::string LineHistory::getString() const
+{
+	std::string result;
+	result.reserve( mSize );
+	size_t first = std::min( mSize, mData.size() - mStart );
+	result.append( mData.data() + mStart, first );
+	result.append( mData.data(), mSize - first );
+	// skip the partial line left at the front after dropping old bytes
+	if( mTruncated ) {
+		auto pos = result.find( '\n' );
+		if( pos != std::string::npos ) {
+			result.erase( 0, pos + 1 );
+		}
+	}
+	return result;
+}
+
+void LineHistory::clear()
+{
+	mStart = mSize = 0;
+	mTruncated = false;
+}
+
+} // namespace runtime
@@ -20,87 +20,202 @@
 */
 
 #include "runtime/Module.h"
+#include "runtime/Epoch.h"
+#include "runtime/ModuleResidency.h"
+#include "runtime/OrcJit.h"
 #include "cinder/Log.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
-#if ! defined( WIN32_LEAN_AND_MEAN )
-	#define WIN32_LEAN_AND_MEAN
+#if defined( CINDER_MSW )
+	#if ! defined( WIN32_LEAN_AND_MEAN )
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <Windows.h>
+#else
+	#include <dlfcn.h>
 #endif
 
-#include <Windows.h>
-
 using namespace std;
 using namespace ci;
 
 namespace runtime {
 
+namespace {
+
+	//! Returns the path of a version of the module at path, "Foo.3.so" for "Foo.so"
+	fs::path getVersionPath( const fs::path &path, uint32_t version )
+	{
+		return path.parent_path() / ( path.stem().string() + "." + to_string( version ) + path.extension().string() );
+	}
+
+	//! Returns the most recent version of the module at path written next to it, 0 if there's none
+	uint32_t findLatestVersion( const fs::path &path )
+	{
+		uint32_t latest = 0;
+		std::error_code errorCode;
+		if( ! fs::is_directory( path.parent_path(), errorCode ) ) {
+			return latest;
+		}
+		auto prefix = path.stem().string() + ".";
+		for( const auto &entry : fs::directory_iterator( path.parent_path(), errorCode ) ) {
+			auto stem = entry.path().stem().string();
+			if( entry.path().extension() == path.extension() && stem.size() > prefix.size() && stem.compare( 0, prefix.size(), prefix ) == 0
+				&& stem.find_first_not_of( "0123456789", prefix.size() ) == string::npos ) {
+				latest = std::max( latest, static_cast<uint32_t>( std::stoul( stem.substr( prefix.size() ) ) ) );
+			}
+		}
+		return latest;
+	}
+
+	//! Loads the library at path with every symbol resolved upfront, so a missing one fails here instead of when it's called
+	void* loadLibrary( const fs::path &path )
+	{
+	#if defined( CINDER_MSW )
+		void* handle = LoadLibrary( path.wstring().c_str() );
+		if( ! handle ) {
+			CI_LOG_E( "Failed to load " << path << ", error " << GetLastError() );
+		}
+	#else
+		// the versions are kept out of the global scope so they don't resolve each other's symbols
+		int flags = RTLD_NOW | RTLD_LOCAL;
+	#if defined( RTLD_DEEPBIND )
+		// and the module uses its own definitions before the ones the app exports, like a dll
+		flags |= RTLD_DEEPBIND;
+	#endif
+		void* handle = dlopen( path.c_str(), flags );
+		if( ! handle ) {
+			CI_LOG_E( "Failed to load " << path << ": " << dlerror() );
+		}
+	#endif
+		return handle;
+	}
+
+	void freeLibrary( void* handle )
+	{
+	#if defined( CINDER_MSW )
+		FreeLibrary( static_cast<HINSTANCE>( handle ) );
+	#else
+		dlclose( handle );
+	#endif
+	}
+
+} // anonymous namespace
+
 Module::Module( const ci::fs::path &path )
-: mPath( path )
-#if defined( CINDER_MSW )
-, mHandle( nullptr )
+: mHandle( nullptr ), mPreviousHandle( nullptr ), mVersion( findLatestVersion( path ) )
+#if defined( RT_ENABLE_ORC_JIT )
+, mJitLibrary( nullptr )
 #endif
+, mManifest( nullptr ), mPath( path )
 {
-	if( fs::exists( path ) ) {
-#if defined( CINDER_MSW )
-		mHandle = LoadLibrary( mPath.wstring().c_str() );
-#else
-#endif
-	}
+	// the most recent version written by a previous session is only loaded by load()
 }
 
 Module::~Module()
 {
-	// release the library
-	if( mHandle ) {
-#if defined( CINDER_MSW )
-		FreeLibrary( static_cast<HINSTANCE>( mHandle ) );
-#endif
-	}
+	ModuleResidency::instance().remove( *this );
 
-	// if the module has been updated there's propbably a temp
-	// file that needs to be removed
-	if( fs::exists( mTempPath ) ) {
-		try {
-			fs::remove( mTempPath );
-		}
-		catch( const fs::filesystem_error & ) {
-		}
+	// the threads calling into the instances might still run the code of either version until they report a quiescent point
+	releasePreviousHandle();
+	if( mHandle ) {
+		auto handle = mHandle;
+		Epoch::instance().retire( [handle]() {
+			freeLibrary( handle );
+		} );
 	}
 }
 
 void Module::updateHandle()
 {
-	if( fs::exists( mPath ) ) {
-		if( mHandle != nullptr ) {
-			FreeLibrary( static_cast<HINSTANCE>( mHandle ) );
+	// loaders identify libraries by their path, a fresh one loads the new version next to the previous one
+	auto nextPath = getNextPath();
+	if( fs::exists( nextPath ) ) {
+		auto handle = loadLibrary( nextPath );
+		if( ! handle ) {
+			return;
 		}
-#if defined( CINDER_MSW )
-		mHandle = LoadLibrary( mPath.wstring().c_str() );
+
+		// the version before hasn't been released by the watcher, but the instances can't use it anymore
+		releasePreviousHandle();
+		mPreviousHandle = mHandle;
+		// the current version is replaced even if it isn't loaded
+		mTempPath = mVersion ? getPath() : fs::path();
+		mHandle = handle;
+		++mVersion;
+#if defined( RT_ENABLE_ORC_JIT )
+		mJitLibrary = nullptr;
 #endif
+		updateManifest();
 	}
 }
 
-void Module::unlockHandle()
+void Module::releasePreviousHandle()
 {
-	if( fs::exists( mPath ) ) {
-		// if the old temp file is still there delete it
-		if( fs::exists( mTempPath ) ) {
-			try {
-				fs::remove( mTempPath );
-			}
-			catch( const fs::filesystem_error & ) {}
-		}
+	if( ! mPreviousHandle && mTempPath.empty() ) {
+		return;
+	}
 
-		// rename the soon to be old module to a temp name
-		mTempPath = mPath.parent_path() / ( mPath.stem().string() + "_old" + mPath.extension().string() );
-		try {
-			fs::rename( mPath, mTempPath );
+	// the threads calling into the instances might still run its code until they report a quiescent point
+	auto handle = mPreviousHandle;
+	auto path = mTempPath;
+	Epoch::instance().retire( [handle, path]() {
+		if( handle ) {
+			freeLibrary( handle );
 		}
-		catch( const fs::filesystem_error & ) {}
+		std::error_code errorCode;
+		fs::remove( path, errorCode );
+	} );
+	mPreviousHandle = nullptr;
+	mTempPath.clear();
+}
+
+bool Module::load()
+{
+	if( ! mHandle && mVersion && fs::exists( getPath() ) ) {
+		mHandle = loadLibrary( getPath() );
+		updateManifest();
+	}
+	return isValid();
+}
+
+void Module::unload()
+{
+	if( ! mHandle ) {
+		return;
+	}
+
+	mCleanupSignal.emit( *this );
+	releasePreviousHandle();
+
+	// the file stays, load() uses it again instead of rebuilding the module
+	auto handle = mHandle;
+	Epoch::instance().retire( [handle]() {
+		freeLibrary( handle );
+	} );
+	mHandle = nullptr;
+	updateManifest();
+}
+
+bool Module::isLoaded() const
+{
+	return mHandle != nullptr;
+}
+
+#if defined( RT_ENABLE_ORC_JIT )
+bool Module::updateObjects( const std::vector<ci::fs::path> &objectPaths )
+{
+	// the previous versions stay linked, instances are moved to the new one by their watcher
+	if( auto library = OrcJit::instance().load( mPath.stem().string(), objectPaths ) ) {
+		mJitLibrary = library;
+		updateManifest();
+		return true;
 	}
+	return false;
 }
+#endif
 
 Module::Handle Module::getHandle() const
 {
@@ -109,7 +224,12 @@ Module::Handle Module::getHandle() const
 
 ci::fs::path Module::getPath() const
 {
-	return mPath;
+	return mVersion ? getVersionPath( mPath, mVersion ) : mPath;
+}
+
+ci::fs::path Module::getNextPath() const
+{
+	return getVersionPath( mPath, mVersion + 1 );
 }
 
 ci::fs::path Module::getTempPath() const
@@ -119,12 +239,48 @@ ci::fs::path Module::getTempPath() const
 
 bool Module::isValid() const
 {
+#if defined( RT_ENABLE_ORC_JIT )
+	if( mJitLibrary ) {
+		return true;
+	}
+#endif
 	return mHandle != nullptr;
 }
 
 void* Module::getSymbolAddress( const std::string &symbol ) const
 {
+#if defined( RT_ENABLE_ORC_JIT )
+	if( mJitLibrary ) {
+		return OrcJit::instance().getSymbolAddress( mJitLibrary, symbol );
+	}
+#endif
+#if defined( CINDER_MSW )
 	return (void*) GetProcAddress( static_cast<HMODULE>( mHandle ), symbol.c_str() );
+#else
+	return mHandle ? dlsym( mHandle, symbol.c_str() ) : nullptr;
+#endif
+}
+
+const ClassManifest* Module::getClassManifest( const std::string &typeName ) const
+{
+	if( mManifest ) {
+		for( uint32_t i = 0; i < mManifest->numClasses; ++i ) {
+			if( typeName == mManifest->classes[i].typeName ) {
+				return &mManifest->classes[i];
+			}
+		}
+	}
+	return nullptr;
+}
+
+void Module::updateManifest()
+{
+	// the only lookup a new version needs, modules built without a generated factory don't export one
+	mManifest = isValid() ? static_cast<const ModuleManifest*>( getSymbolAddress( "rt_module_manifest" ) ) : nullptr;
+	if( mManifest && mManifest->version != RT_MODULE_MANIFEST_VERSION ) {
+		CI_LOG_W( "Ignoring the manifest of " << getPath() << ", its version " << mManifest->version << " isn't supported" );
+		mManifest = nullptr;
+	}
 }
 
 ci::signals::Signal<void( const Module& )>& Module::getCleanupSignal()
@@ -0,0 +1,78 @@
+#include "runtime/ModuleResidency.h"
+#include "runtime/Module.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+namespace runtime {
+
+ModuleResidency& ModuleResidency::instance()
+{
+	static ModuleResidency residency;
+	return residency;
+}
+
+ModuleResidency::ModuleResidency()
+: mMaxResidentModules( 0 )
+{
+}
+
+void ModuleResidency::touch( Module &module, const IdleFn &isIdle )
+{
+	{
+		lock_guard<mutex> lock( mMutex );
+		auto it = std::find_if( mResidents.begin(), mResidents.end(), [&module]( const Resident &resident ) { return resident.module == &module; } );
+		if( it != mResidents.end() ) {
+			mResidents.splice( mResidents.begin(), mResidents, it );
+		}
+		else {
+			mResidents.push_front( { &module, isIdle } );
+		}
+	}
+	trim();
+}
+
+void ModuleResidency::trim()
+{
+	std::vector<Module*> evicted;
+	{
+		lock_guard<mutex> lock( mMutex );
+		for( auto it = mResidents.end(); it != mResidents.begin() && mResidents.size() > mMaxResidentModules; ) {
+			--it;
+			if( it->isIdle() ) {
+				evicted.push_back( it->module );
+				it = mResidents.erase( it );
+			}
+		}
+	}
+
+	// outside of the lock, the cleanup signal of a module can create instances of another one
+	for( auto module : evicted ) {
+		module->unload();
+	}
+}
+
+void ModuleResidency::remove( Module &module )
+{
+	lock_guard<mutex> lock( mMutex );
+	mResidents.remove_if( [&module]( const Resident &resident ) { return resident.module == &module; } );
+}
+
+void ModuleResidency::setMaxResidentModules( size_t maxResidentModules )
+{
+	{
+		lock_guard<mutex> lock( mMutex );
+		mMaxResidentModules = maxResidentModules;
+	}
+	trim();
+}
+
+size_t ModuleResidency::getNumResidentModules() const
+{
+	lock_guard<mutex> lock( mMutex );
+	return mResidents.size();
+}
+
+} // namespace runtime
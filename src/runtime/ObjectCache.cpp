@@ -0,0 +1,112 @@
+#include "runtime/ObjectCache.h"
+#include "runtime/BuildGraph.h"
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+namespace {
+	const uint64_t sFnvOffsetBasis = 14695981039346656037ull;
+	const uint64_t sFnvPrime = 1099511628211ull;
+
+	inline uint64_t hashBytes( uint64_t hash, const char* data, size_t size )
+	{
+		for( size_t i = 0; i < size; ++i ) {
+			hash = ( hash ^ static_cast<unsigned char>( data[i] ) ) * sFnvPrime;
+		}
+		return hash;
+	}
+} // anonymous namespace
+
+ObjectCache::ObjectCache( const ci::fs::path &directory )
+: mDirectory( directory )
+{
+}
+
+uint64_t ObjectCache::computeKey( const ci::fs::path &preprocessedPath, const std::string &compileCommand )
+{
+	std::ifstream file( preprocessedPath, std::ios::binary );
+	if( ! file ) {
+		return 0;
+	}
+
+	// 64-bit FNV-1a over the preprocessed source followed by the command
+	uint64_t hash = sFnvOffsetBasis;
+	std::vector<char> buffer( 64 * 1024 );
+	while( file ) {
+		file.read( buffer.data(), buffer.size() );
+		hash = hashBytes( hash, buffer.data(), static_cast<size_t>( file.gcount() ) );
+	}
+	hash = hashBytes( hash, compileCommand.data(), compileCommand.size() );
+	// 0 means no key
+	return hash ? hash : 1;
+}
+
+ci::fs::path ObjectCache::getObjectPath( uint64_t key, const ci::fs::path &extension ) const
+{
+	std::ostringstream name;
+	name << std::hex << std::setfill( '0' ) << std::setw( 16 ) << key;
+	return mDirectory / ( name.str() + extension.string() );
+}
+
+bool ObjectCache::fetch( uint64_t key, const ci::fs::path &objectPath ) const
+{
+	auto cachedPath = getObjectPath( key, objectPath.extension() );
+	std::error_code errorCode;
+	if( ! key || ! fs::exists( cachedPath, errorCode ) ) {
+		return false;
+	}
+	fs::create_directories( objectPath.parent_path(), errorCode );
+	if( ! fs::copy_file( cachedPath, objectPath, fs::copy_options::overwrite_existing, errorCode ) || errorCode ) {
+		return false;
+	}
+	// the objects used the least recently are the first ones trimmed by rt::BuildArtifacts
+	fs::last_write_time( cachedPath, fs::file_time_type::clock::now(), errorCode );
+	return true;
+}
+
+void ObjectCache::store( uint64_t key, const ci::fs::path &objectPath ) const
+{
+	std::error_code errorCode;
+	if( ! key || ! fs::exists( objectPath, errorCode ) ) {
+		return;
+	}
+	// copy next to the final name first so a concurrent fetch never sees a partial object
+	auto cachedPath = getObjectPath( key, objectPath.extension() );
+	auto temporaryPath = cachedPath;
+	temporaryPath += ".tmp";
+	fs::create_directories( mDirectory, errorCode );
+	if( fs::copy_file( objectPath, temporaryPath, fs::copy_options::overwrite_existing, errorCode ) ) {
+		fs::rename( temporaryPath, cachedPath, errorCode );
+	}
+}
+
+size_t ObjectCache::addCompileJobs( BuildGraph *graph, const std::string &label, const std::string &preprocessCommand, const ci::fs::path &preprocessedPath, const std::string &compileCommand, const ci::fs::path &objectPath, const std::vector<size_t> &dependencies ) const
+{
+	// the preprocessor doesn't need anything built beforehand and runs alongside the precompiled header
+	auto preprocessJob = graph->addJob( "", preprocessCommand );
+	auto compileDependencies = dependencies;
+	compileDependencies.push_back( preprocessJob );
+	auto compileJob = graph->addJob( label, compileCommand, compileDependencies );
+
+	// the key is computed off the main thread once the preprocessed source exists, and kept to store the fresh object once the compile job it precedes succeeded
+	auto key = std::make_shared<uint64_t>( 0 );
+	ObjectCache cache = *this;
+	graph->setUpToDateCheck( compileJob, [cache, key, preprocessedPath, compileCommand, objectPath]() {
+		*key = computeKey( preprocessedPath, compileCommand );
+		return cache.fetch( *key, objectPath );
+	} );
+	graph->setSuccessHandler( compileJob, [cache, key, objectPath]() {
+		cache.store( *key, objectPath );
+	} );
+
+	return compileJob;
+}
+
+} // namespace runtime
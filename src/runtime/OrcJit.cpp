@@ -0,0 +1,162 @@
+#include "runtime/OrcJit.h"
+
+#if defined( RT_ENABLE_ORC_JIT )
+
+#include "cinder/Log.h"
+
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ObjectFileInterface.h"
+#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace ci;
+using namespace llvm;
+using namespace llvm::orc;
+
+namespace runtime {
+
+OrcJit& OrcJit::instance()
+{
+	static OrcJit jit;
+	return jit;
+}
+
+OrcJit::OrcJit()
+{
+	InitializeNativeTarget();
+	InitializeNativeTargetAsmPrinter();
+
+	// the objects are loaded by RuntimeDyld, which tells where the sections holding the static initializers end up
+	auto jit = LLJITBuilder().setObjectLinkingLayerCreator( [this]( ExecutionSession &session, const Triple &triple ) {
+		auto layer = std::make_unique<RTDyldObjectLinkingLayer>( session, []() { return std::make_unique<SectionMemoryManager>(); } );
+		if( triple.isOSBinFormatCOFF() ) {
+			layer->setOverrideObjectFlagsWithResponsibilityFlags( true );
+			layer->setAutoClaimResponsibilityForObjectSymbols( true );
+		}
+		layer->setNotifyLoaded( [this]( MaterializationResponsibility &, const object::ObjectFile &object, const RuntimeDyld::LoadedObjectInfo &info ) {
+			for( const auto &section : object.sections() ) {
+				auto name = section.getName();
+				if( ! name ) {
+					consumeError( name.takeError() );
+					continue;
+				}
+				if( name->startswith( ".init_array" ) || name->startswith( ".CRT$XC" ) ) {
+					if( auto address = info.getSectionLoadAddress( section ) ) {
+						mPendingInitializers.push_back( { name->str(), address, section.getSize() } );
+					}
+				}
+			}
+		} );
+		return Expected<std::unique_ptr<ObjectLayer>>( std::move( layer ) );
+	} ).create();
+	if( ! jit ) {
+		CI_LOG_E( "Failed to create the ORC JIT: " << toString( jit.takeError() ) );
+		return;
+	}
+	mJit = std::move( *jit );
+	mJit->getExecutionSession().setErrorReporter( []( Error error ) {
+		CI_LOG_E( toString( std::move( error ) ) );
+	} );
+
+	// the libraries resolve what they don't define against the app and the libraries it loaded
+	auto processSymbols = DynamicLibrarySearchGenerator::GetForCurrentProcess( mJit->getDataLayout().getGlobalPrefix() );
+	if( ! processSymbols ) {
+		CI_LOG_E( "Failed to create the ORC JIT: " << toString( processSymbols.takeError() ) );
+		mJit.reset();
+		return;
+	}
+	mJit->getMainJITDylib().addGenerator( std::move( *processSymbols ) );
+}
+
+OrcJit::~OrcJit()
+{
+}
+
+void* OrcJit::load( const std::string &name, const std::vector<ci::fs::path> &objectPaths )
+{
+	if( ! mJit ) {
+		return nullptr;
+	}
+
+	// every version is a new library, symbols can't be defined twice in the same one. The previous versions stay alive as instances or callbacks might still use their code
+	auto libraryName = name + "." + to_string( ++mVersions[name] );
+	auto library = mJit->createJITDylib( libraryName );
+	if( ! library ) {
+		CI_LOG_E( "Failed to create " << libraryName << ": " << toString( library.takeError() ) );
+		return nullptr;
+	}
+	library->addToLinkOrder( mJit->getMainJITDylib() );
+
+	auto &session = mJit->getExecutionSession();
+	SymbolLookupSet symbols;
+	for( const auto &objectPath : objectPaths ) {
+		auto buffer = MemoryBuffer::getFile( objectPath.string() );
+		if( ! buffer ) {
+			CI_LOG_E( "Failed to read " << objectPath << ": " << buffer.getError().message() );
+			return nullptr;
+		}
+		// objects are only linked once one of their symbols is looked up, all of them are so that everything is linked now
+		auto interface = getObjectFileInterface( session, ( *buffer )->getMemBufferRef() );
+		if( ! interface ) {
+			CI_LOG_E( "Failed to read " << objectPath << ": " << toString( interface.takeError() ) );
+			return nullptr;
+		}
+		for( const auto &symbol : interface->SymbolFlags ) {
+			if( ! symbol.second.hasMaterializationSideEffectsOnly() ) {
+				symbols.add( symbol.first, SymbolLookupFlags::WeaklyReferencedSymbol );
+			}
+		}
+		if( auto error = mJit->addObjectFile( *library, std::move( *buffer ) ) ) {
+			CI_LOG_E( "Failed to add " << objectPath << " to " << libraryName << ": " << toString( std::move( error ) ) );
+			return nullptr;
+		}
+	}
+
+	mPendingInitializers.clear();
+	auto linked = session.lookup( makeJITDylibSearchOrder( &*library, JITDylibLookupFlags::MatchAllSymbols ), symbols );
+	if( ! linked ) {
+		CI_LOG_E( "Failed to link " << libraryName << ": " << toString( linked.takeError() ) );
+		mPendingInitializers.clear();
+		return nullptr;
+	}
+
+	// prioritized .init_array.<N> sections run before .init_array, .CRT$XC* sections run in alphabetical order
+	auto initializers = std::move( mPendingInitializers );
+	mPendingInitializers.clear();
+	auto getOrder = []( const Initializers &initializers ) { return initializers.section == ".init_array" ? string( ".init_array.~" ) : initializers.section; };
+	std::stable_sort( initializers.begin(), initializers.end(), [&]( const Initializers &a, const Initializers &b ) { return getOrder( a ) < getOrder( b ); } );
+	for( const auto &section : initializers ) {
+		auto functions = reinterpret_cast<void(**)()>( static_cast<uintptr_t>( section.address ) );
+		for( size_t i = 0; i < section.size / sizeof( void* ); ++i ) {
+			if( functions[i] ) {
+				functions[i]();
+			}
+		}
+	}
+
+	return &*library;
+}
+
+void* OrcJit::getSymbolAddress( void* library, const std::string &symbol ) const
+{
+	if( ! mJit || ! library ) {
+		return nullptr;
+	}
+
+	auto address = mJit->lookup( *static_cast<JITDylib*>( library ), symbol );
+	if( ! address ) {
+		consumeError( address.takeError() );
+		return nullptr;
+	}
+	return reinterpret_cast<void*>( static_cast<uintptr_t>( address->getAddress() ) );
+}
+
+} // namespace runtime
+
+#endif
@@ -2,6 +2,7 @@
 #include "cinder/app/App.h"
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 
 using namespace std;
 using namespace ci;
@@ -29,6 +30,198 @@ std::vector<string> extractHeaderLines( const ci::fs::path &inputPath, const std
 	return includes;
 }
 
+//! 64-bit FNV-1a
+uint64_t hashBytes( uint64_t hash, const char* data, size_t size )
+{
+	for( size_t i = 0; i < size; ++i ) {
+		hash = ( hash ^ static_cast<unsigned char>( data[i] ) ) * 1099511628211ull;
+	}
+	return hash;
+}
+
+uint64_t hashString( uint64_t hash, const std::string &str )
+{
+	return hashBytes( hash, str.data(), str.size() );
+}
+
+//! 64-bit FNV-1a of the content of the file at path, 0 if it can't be read
+uint64_t hashFile( const ci::fs::path &path )
+{
+	std::ifstream file( path, std::ios::binary );
+	if( ! file ) {
+		return 0;
+	}
+	uint64_t hash = 14695981039346656037ull;
+	std::vector<char> buffer( 64 * 1024 );
+	while( file ) {
+		file.read( buffer.data(), buffer.size() );
+		hash = hashBytes( hash, buffer.data(), static_cast<size_t>( file.gcount() ) );
+	}
+	return hash ? hash : 1;
+}
+
+int64_t getWriteTime( const ci::fs::path &path )
+{
+	std::error_code errorCode;
+	auto time = fs::last_write_time( path, errorCode );
+	return errorCode ? 0 : static_cast<int64_t>( time.time_since_epoch().count() );
+}
+
+}
+
+std::vector<std::string> getPrecompiledHeaderIncludes( const ci::fs::path &inputCpp )
+{
+	auto className = inputCpp.stem().string();
+	auto includes = extractHeaderLines( inputCpp, className );
+	auto headerIncludes = extractHeaderLines( inputCpp.parent_path() / inputCpp.stem().replace_extension( ".h" ), className );
+	includes.insert( includes.end(), headerIncludes.begin(), headerIncludes.end() );
+	return includes;
+}
+
+PrecompiledHeaderPool::PrecompiledHeaderPool( const ci::fs::path &directory )
+: mDirectory( directory )
+{
+}
+
+bool PrecompiledHeaderPool::acquire( const std::vector<std::string> &includes, const std::string &flags, Entry *entry ) const
+{
+	if( includes.empty() ) {
+		return false;
+	}
+
+	// the order of the includes matters as much as their content
+	uint64_t hash = 14695981039346656037ull;
+	for( const auto &include : includes ) {
+		hash = hashString( hash, include + "\n" );
+	}
+	hash = hashString( hash, flags );
+
+	std::ostringstream key;
+	key << std::hex << std::setfill( '0' ) << std::setw( 16 ) << hash;
+	entry->key = key.str();
+	entry->directory = mDirectory / entry->key;
+	entry->header = entry->directory / "Pch.h";
+	entry->source = entry->directory / "Pch.cpp";
+
+	// the content never changes for a given key, the files are only written once
+	if( ! fs::exists( entry->header ) || ! fs::exists( entry->source ) ) {
+		fs::create_directories( entry->directory );
+		std::ofstream pchHeaderFile( entry->header );
+		pchHeaderFile << "#pragma once" << endl << endl;
+		for( const auto &include : includes ) {
+			pchHeaderFile << include << endl;
+		}
+		std::ofstream pchSourceFile( entry->source );
+		pchSourceFile << "#include \"" << entry->header.generic_string() << "\"" << endl;
+	}
+	return true;
+}
+
+void PrecompiledHeaderPool::acquireHeaderUnit( const std::string &header, const std::string &flags, Entry *entry ) const
+{
+	// header units built with the same flags are imported together, they live side by side
+	std::ostringstream key;
+	key << std::hex << std::setfill( '0' ) << std::setw( 16 ) << hashString( hashString( 14695981039346656037ull, header + "\n" ), flags );
+	entry->key = key.str();
+	entry->directory = getHeaderUnitsDirectory( flags ) / entry->key;
+	entry->header = header;
+	entry->source.clear();
+	fs::create_directories( entry->directory );
+}
+
+ci::fs::path PrecompiledHeaderPool::getHeaderUnitsDirectory( const std::string &flags ) const
+{
+	std::ostringstream key;
+	key << std::hex << std::setfill( '0' ) << std::setw( 16 ) << hashString( 14695981039346656037ull, flags );
+	return mDirectory / key.str();
+}
+
+bool PrecompiledHeaderPool::isUpToDate( const Entry &entry, const ci::fs::path &outputPath ) const
+{
+	std::ifstream dependenciesFile( getDependenciesPath( entry ) );
+	if( ! dependenciesFile || ! fs::exists( outputPath ) ) {
+		return false;
+	}
+
+	// "<hash> <write time> <path>" per header, the hash is only computed again when the write time moved
+	struct Dependency {
+		uint64_t		hash;
+		int64_t			writeTime;
+		ci::fs::path	path;
+	};
+	std::vector<Dependency> dependencies;
+	bool touched = false;
+	for( string line; std::getline( dependenciesFile, line ); ) {
+		std::istringstream lineStream( line );
+		Dependency dependency;
+		string path;
+		lineStream >> std::hex >> dependency.hash >> std::dec >> dependency.writeTime;
+		if( ! lineStream || ! std::getline( lineStream >> std::ws, path ) ) {
+			return false;
+		}
+		dependency.path = path;
+		auto writeTime = getWriteTime( dependency.path );
+		if( writeTime != dependency.writeTime ) {
+			if( hashFile( dependency.path ) != dependency.hash ) {
+				return false;
+			}
+			// saved without changes, remember the new time to skip the hash next time
+			dependency.writeTime = writeTime;
+			touched = true;
+		}
+		dependencies.push_back( dependency );
+	}
+	dependenciesFile.close();
+
+	// nothing tells whether a header of an entry without a record changed
+	if( dependencies.empty() ) {
+		return false;
+	}
+
+	if( touched ) {
+		std::ofstream updatedFile( getDependenciesPath( entry ) );
+		for( const auto &dependency : dependencies ) {
+			updatedFile << std::hex << std::setfill( '0' ) << std::setw( 16 ) << dependency.hash << std::dec << " " << dependency.writeTime << " " << dependency.path.generic_string() << endl;
+		}
+	}
+	return true;
+}
+
+void PrecompiledHeaderPool::recordDependencies( const Entry &entry, const std::vector<ci::fs::path> &headers ) const
+{
+	// every precompiled header includes something, the compiler output didn't list it
+	if( headers.empty() ) {
+		invalidate( entry );
+		return;
+	}
+
+	std::ofstream dependenciesFile( getDependenciesPath( entry ) );
+	for( const auto &header : headers ) {
+		dependenciesFile << std::hex << std::setfill( '0' ) << std::setw( 16 ) << hashFile( header ) << std::dec << " " << getWriteTime( header ) << " " << header.generic_string() << endl;
+	}
+}
+
+void PrecompiledHeaderPool::invalidate( const Entry &entry ) const
+{
+	std::error_code errorCode;
+	fs::remove( getDependenciesPath( entry ), errorCode );
+}
+
+std::vector<ci::fs::path> PrecompiledHeaderPool::getDependencies( const Entry &entry ) const
+{
+	std::vector<ci::fs::path> headers;
+	std::ifstream dependenciesFile( getDependenciesPath( entry ) );
+	for( string line; std::getline( dependenciesFile, line ); ) {
+		std::istringstream lineStream( line );
+		uint64_t hash;
+		int64_t writeTime;
+		string path;
+		lineStream >> std::hex >> hash >> std::dec >> writeTime;
+		if( lineStream && std::getline( lineStream >> std::ws, path ) ) {
+			headers.push_back( path );
+		}
+	}
+	return headers;
 }
 
 bool generatePrecompiledHeader( const ci::fs::path &inputCpp, const ci::fs::path &outputHeader, const ci::fs::path &outputCpp, bool force )
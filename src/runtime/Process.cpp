@@ -1,13 +1,14 @@
 #include "runtime/Process.h"
 
+#include <array>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+
 #if ! defined( WIN32_LEAN_AND_MEAN )
 	#define WIN32_LEAN_AND_MEAN
 #endif
 
 #include <windows.h>
-#include <array>
-
-#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
 
 namespace {
 	//! Managed Handle class. Release handle on destruction
@@ -39,8 +40,319 @@ namespace {
 
 } // anonymous namespace
 #else
+
+#include <algorithm>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#if defined( __linux__ )
+#include <sys/syscall.h>
+#elif defined( __APPLE__ )
+#include <sys/event.h>
 #endif
 
+extern char **environ;
+
+namespace {
+	//! Managed file descriptor class. Closes the descriptor on destruction
+	class ManagedDescriptor {
+	public:
+		ManagedDescriptor() : mFd( -1 ) {}
+		~ManagedDescriptor() { if( mFd != -1 ) ::close( mFd ); }
+		int detach() { int fd = mFd; mFd = -1; return fd; }
+		void reset( int fd ) { if( mFd != -1 ) ::close( mFd ); mFd = fd; }
+		operator int() const { return mFd; }
+	private:
+		int mFd;
+	};
+
+	//! Single-quotes argument for sh, a quote inside it closes the quoted string, is escaped and reopens it
+	std::string quoteArgument( const std::string &argument )
+	{
+		std::string quoted = "'";
+		for( char c : argument ) {
+			if( c == '\'' ) {
+				quoted += "'\\''";
+			}
+			else {
+				quoted += c;
+			}
+		}
+		return quoted + "'";
+	}
+
+	//! Creates a pipe whose both ends are closed on exec so that concurrently spawned processes don't inherit them
+	bool createPipe( ManagedDescriptor &readEnd, ManagedDescriptor &writeEnd )
+	{
+		int fds[2];
+	#if defined( __linux__ )
+		if( pipe2( fds, O_CLOEXEC ) != 0 ) {
+			return false;
+		}
+	#else
+		if( pipe( fds ) != 0 ) {
+			return false;
+		}
+		fcntl( fds[0], F_SETFD, FD_CLOEXEC );
+		fcntl( fds[1], F_SETFD, FD_CLOEXEC );
+	#endif
+		readEnd.reset( fds[0] );
+		writeEnd.reset( fds[1] );
+		return true;
+	}
+
+	//! Returns a descriptor that becomes readable once the process pid exits, -1 if the system can't provide one
+	int openExitDescriptor( pid_t pid )
+	{
+	#if defined( __linux__ ) && defined( SYS_pidfd_open )
+		// close on exec by default, fails with ENOSYS before Linux 5.3
+		return static_cast<int>( syscall( SYS_pidfd_open, pid, 0 ) );
+	#elif defined( __APPLE__ )
+		int queue = kqueue();
+		if( queue < 0 ) {
+			return -1;
+		}
+		struct kevent event;
+		EV_SET( &event, pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, nullptr );
+		if( kevent( queue, &event, 1, nullptr, 0, nullptr ) < 0 ) {
+			::close( queue );
+			return -1;
+		}
+		return queue;
+	#else
+		return -1;
+	#endif
+	}
+
+	//! Writes size bytes of data to fd. If the read end is closed the write fails with EPIPE, the app's SIGPIPE handling is left untouched.
+	bool writeAll( int fd, const char* data, size_t size )
+	{
+	#if ! defined( F_SETNOSIGPIPE )
+		// the signal is raised for the writing thread, keep it pending while writing and consume it if the write raised it
+		sigset_t sigPipe, previousMask, pending;
+		sigemptyset( &sigPipe );
+		sigaddset( &sigPipe, SIGPIPE );
+		pthread_sigmask( SIG_BLOCK, &sigPipe, &previousMask );
+		bool wasPending = sigpending( &pending ) == 0 && sigismember( &pending, SIGPIPE );
+	#endif
+		bool brokenPipe = false;
+		size_t written = 0;
+		while( written < size ) {
+			ssize_t result = ::write( fd, data + written, size - written );
+			if( result < 0 ) {
+				if( errno == EINTR ) continue;
+				brokenPipe = errno == EPIPE;
+				break;
+			}
+			written += static_cast<size_t>( result );
+		}
+	#if ! defined( F_SETNOSIGPIPE )
+		if( brokenPipe && ! wasPending ) {
+			struct timespec noWait = { 0, 0 };
+			while( sigtimedwait( &sigPipe, nullptr, &noWait ) < 0 && errno == EINTR );
+		}
+		pthread_sigmask( SIG_SETMASK, &previousMask, nullptr );
+	#endif
+		return written == size;
+	}
+
+	//! Single thread servicing the redirected pipes of every live Process with poll()
+	class PipeReader {
+	public:
+		using ReadFn = std::function<void( const char*, size_t )>;
+		using CloseFn = std::function<void()>;
+
+		static PipeReader& instance();
+
+		//! Starts watching fd and returns its id. readFn is called on the reader thread for every chunk read, closeFn once the pipe reached EOF and fd has been closed. Without readFn fd is only waited on, closeFn is called once it is readable.
+		uint64_t add( int fd, const ReadFn &readFn, const CloseFn &closeFn );
+		//! Reads what is left in the pipe added as id without waiting for more and closes it, even if a process still holds its write end
+		void close( uint64_t id );
+		
+		~PipeReader();
+	protected:
+		PipeReader();
+		void run();
+		void wake();
+
+		struct Pipe {
+			uint64_t	id;
+			int			fd;
+			ReadFn		readFn;
+			CloseFn		closeFn;
+		};
+
+		std::mutex			mPendingMutex;
+		std::vector<Pipe>	mPending;
+		std::vector<uint64_t>	mClosing;
+		uint64_t			mNextId;
+		std::atomic<bool>	mRunning;
+		std::thread			mThread;
+		ManagedDescriptor	mWakeRead;
+		ManagedDescriptor	mWakeWrite;
+	};
+
+	PipeReader& PipeReader::instance()
+	{
+		static PipeReader reader;
+		return reader;
+	}
+
+	PipeReader::PipeReader()
+	: mNextId( 1 ), mRunning( true )
+	{
+		if( ! createPipe( mWakeRead, mWakeWrite ) ) {
+			throw ProcessExc( "Failed Creating Pipe Reader Wake Pipe" );
+		}
+		fcntl( mWakeRead, F_SETFL, O_NONBLOCK );
+		mThread = std::thread( &PipeReader::run, this );
+	}
+
+	PipeReader::~PipeReader()
+	{
+		mRunning = false;
+		wake();
+		if( mThread.joinable() ) {
+			mThread.join();
+		}
+	}
+
+	uint64_t PipeReader::add( int fd, const ReadFn &readFn, const CloseFn &closeFn )
+	{
+		uint64_t id;
+		{
+			std::lock_guard<std::mutex> lock( mPendingMutex );
+			id = mNextId++;
+			mPending.push_back( { id, fd, readFn, closeFn } );
+		}
+		wake();
+		return id;
+	}
+
+	void PipeReader::close( uint64_t id )
+	{
+		{
+			std::lock_guard<std::mutex> lock( mPendingMutex );
+			mClosing.push_back( id );
+		}
+		wake();
+	}
+
+	void PipeReader::wake()
+	{
+		char c = 0;
+		while( ::write( mWakeWrite, &c, 1 ) < 0 && errno == EINTR );
+	}
+
+	void PipeReader::run()
+	{
+		std::vector<Pipe> pipes;
+		std::vector<uint64_t> closing;
+		std::vector<pollfd> pollFds;
+		std::array<char, 65536> buffer;
+		while( mRunning ) {
+			// pick up the pipes registered and the ones to close since the last iteration
+			{
+				std::lock_guard<std::mutex> lock( mPendingMutex );
+				pipes.insert( pipes.end(), mPending.begin(), mPending.end() );
+				mPending.clear();
+				closing.swap( mClosing );
+			}
+			for( uint64_t id : closing ) {
+				auto pipeIt = std::find_if( pipes.begin(), pipes.end(), [id]( const Pipe &pipe ) { return pipe.id == id; } );
+				if( pipeIt == pipes.end() ) {
+					continue;
+				}
+				// drain what was written before the request, nothing else is waited for
+				fcntl( pipeIt->fd, F_SETFL, O_NONBLOCK );
+				ssize_t readBytes;
+				while( pipeIt->readFn && ( readBytes = ::read( pipeIt->fd, buffer.data(), buffer.size() ) ) != 0 ) {
+					if( readBytes > 0 ) {
+						pipeIt->readFn( buffer.data(), static_cast<size_t>( readBytes ) );
+					}
+					else if( errno != EINTR ) {
+						break;
+					}
+				}
+				::close( pipeIt->fd );
+				CloseFn closeFn = pipeIt->closeFn;
+				pipes.erase( pipeIt );
+				closeFn();
+			}
+			closing.clear();
+
+			// the first entry is always the wake pipe
+			pollFds.resize( pipes.size() + 1 );
+			pollFds[0] = { mWakeRead, POLLIN, 0 };
+			for( size_t i = 0; i < pipes.size(); ++i ) {
+				pollFds[i + 1] = { pipes[i].fd, POLLIN, 0 };
+			}
+
+			if( poll( pollFds.data(), static_cast<nfds_t>( pollFds.size() ), -1 ) < 0 ) {
+				if( errno == EINTR ) continue;
+				break;
+			}
+
+			// drain the wake pipe
+			if( pollFds[0].revents & POLLIN ) {
+				while( ::read( mWakeRead, buffer.data(), buffer.size() ) > 0 );
+			}
+			
+			// service the pipes in reverse order so closed ones can be erased in place
+			for( size_t i = pipes.size(); i > 0; --i ) {
+				const auto &pollFd = pollFds[i];
+				if( ! ( pollFd.revents & ( POLLIN | POLLHUP | POLLERR | POLLNVAL ) ) ) {
+					continue;
+				}
+				Pipe &pipe = pipes[i - 1];
+				ssize_t readBytes = pipe.readFn ? ::read( pipe.fd, buffer.data(), buffer.size() ) : 0;
+				if( readBytes > 0 ) {
+					pipe.readFn( buffer.data(), static_cast<size_t>( readBytes ) );
+				}
+				else if( readBytes == 0 || ( errno != EINTR && errno != EAGAIN ) ) {
+					::close( pipe.fd );
+					CloseFn closeFn = pipe.closeFn;
+					pipes.erase( pipes.begin() + ( i - 1 ) );
+					closeFn();
+				}
+			}
+		}
+	}
+
+	int16_t decodeExitStatus( int status )
+	{
+		if( WIFEXITED( status ) ) {
+			return static_cast<int16_t>( WEXITSTATUS( status ) );
+		}
+		else if( WIFSIGNALED( status ) ) {
+			return static_cast<int16_t>( 128 + WTERMSIG( status ) );
+		}
+		return -1;
+	}
+
+} // anonymous namespace
+#endif
+
+namespace {
+	//! Appends data to str, keeping at most the last limit bytes when limit isn't 0
+	void appendBounded( std::string &str, const char* data, size_t size, size_t limit )
+	{
+		str.append( data, size );
+		// trim lazily to amortize the cost of moving the string content
+		if( limit && str.size() > 2 * limit ) {
+			str.erase( 0, str.size() - limit );
+		}
+	}
+} // anonymous namespace
+
 // https://support.microsoft.com/en-us/kb/190351
 // https://msdn.microsoft.com/en-us/library/ms682499.aspx
 // 
@@ -54,15 +366,21 @@ namespace {
 // namedpipes https://msdn.microsoft.com/en-us/library/aa365603(VS.85).aspx
 // namedpipes https://www.daniweb.com/programming/software-development/threads/295780/using-named-pipes-with-asynchronous-i-o-redirection-to-winapi
 
-Process::Process( const std::string &cmd, bool redirectOutput, bool redirectError, bool redirectInput ) : Process( cmd, "", redirectOutput, redirectError, redirectInput ) {}
-Process::Process( const std::string &cmd, const std::string &path, bool redirectOutput, bool redirectError, bool redirectInput )
-: mIsOutputQueueEmpty( true ), mIsErrorQueueEmpty( true )
+Process::Process( const std::string &cmd, bool redirectOutput, bool redirectError, bool redirectInput, bool mergeError ) : Process( cmd, "", redirectOutput, redirectError, redirectInput, mergeError ) {}
+// the rings only allocate their capacity once something is written to them, which never happens to the output ring once a handler is set or to the error ring when StdErr isn't redirected
+Process::Process( const std::string &cmd, const std::string &path, bool redirectOutput, bool redirectError, bool redirectInput, bool mergeError )
+: mSyncOutputLimit( 0 ), mOutputRing( 1 << 22 ), mErrorRing( 1 << 20 )
 {
+	// StdErr shares the output pipe instead of having its own
+	if( mergeError ) {
+		redirectError = false;
+	}
 
 #if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
 	mOutputRead = nullptr;
 	mErrorRead = nullptr;
 	mInputWrite = nullptr;
+	mJob = nullptr;
 	ManagedHandle outputRead;
 	ManagedHandle outputWrite;
 	ManagedHandle errorRead;
@@ -115,6 +433,10 @@ Process::Process( const std::string &cmd, const std::string &path, bool redirect
 		startupInfo.dwFlags |= STARTF_USESTDHANDLES;
 		startupInfo.hStdError = errorWrite;
 	}
+	else if( mergeError && redirectOutput ) {
+		startupInfo.dwFlags |= STARTF_USESTDHANDLES;
+		startupInfo.hStdError = outputWrite;
+	}
 	if( redirectInput ) {
 		startupInfo.dwFlags |= STARTF_USESTDHANDLES;
 		startupInfo.hStdInput = inputRead;
@@ -123,7 +445,8 @@ Process::Process( const std::string &cmd, const std::string &path, bool redirect
 	// Initialize the new process
 	PROCESS_INFORMATION processInfo;
 	ZeroMemory( &processInfo, sizeof(processInfo) );
-	DWORD creationFlags = CREATE_UNICODE_ENVIRONMENT;//| CREATE_NEW_CONSOLE; //0;
+	// start suspended so the process is in its job before it gets a chance to start children
+	DWORD creationFlags = CREATE_UNICODE_ENVIRONMENT | CREATE_SUSPENDED;//| CREATE_NEW_CONSOLE; //0;
 	if( ! CreateProcessW( nullptr,							// Application Name
 						 cmd.empty() ?						// Command Line
 						 nullptr : (LPWSTR) std::wstring( cmd.begin(), cmd.end() ).c_str(),	
@@ -144,6 +467,20 @@ Process::Process( const std::string &cmd, const std::string &path, bool redirect
 		throw ProcessExc( "Failed Creating Process" );
 	}
 	else {
+		// Put the process and everything it starts in a job so kill() can take the whole tree down
+		mJob = CreateJobObjectW( nullptr, nullptr );
+		if( mJob ) {
+			JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobLimits;
+			ZeroMemory( &jobLimits, sizeof(jobLimits) );
+			// processes explicitly breaking away (mspdbsrv is shared by every compiler) are allowed to outlive the job
+			jobLimits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE | JOB_OBJECT_LIMIT_BREAKAWAY_OK;
+			if( ! SetInformationJobObject( mJob, JobObjectExtendedLimitInformation, &jobLimits, sizeof(jobLimits) ) ||
+				! AssignProcessToJobObject( mJob, processInfo.hProcess ) ) {
+				CloseHandle( mJob );
+				mJob = nullptr;
+			}
+		}
+		ResumeThread( processInfo.hThread );
 		// Close ProcessInfo thread handle
 		CloseHandle( processInfo.hThread );
 		// And keep a reference to its process handle
@@ -171,18 +508,10 @@ Process::Process( const std::string &cmd, const std::string &path, bool redirect
 			DWORD readBytes;
 			std::array<char, 65536> buffer;
 			while( ReadFile( mOutputRead, buffer.data(), static_cast<DWORD>(65536), &readBytes, nullptr ) && readBytes != 0 ) {
-				// copy the buffer into a string
-				std::string output( buffer.begin(), buffer.begin() + readBytes );
-				// add the string to the sync output
-				outputStr += output;
-				// push the string to the async queue
-				std::lock_guard<std::mutex> queueLock( mOutputQueueMutex );
-				bool wasEmpty = mOutputQueue.empty();
-				mOutputQueue.push( output );
-				if( wasEmpty ) {
-					std::lock_guard<std::mutex> queueEmptyLock( mOutputQueueEmptyMutex );
-					mIsOutputQueueEmpty = false;
-				}
+				// add the chunk to the sync output
+				appendBounded( outputStr, buffer.data(), readBytes, mSyncOutputLimit );
+				// and to the output handler or the async ring
+				pushOutput( buffer.data(), readBytes );
 			}
 			// send back the sync output
 			outputPromise.set_value( outputStr );
@@ -198,18 +527,10 @@ Process::Process( const std::string &cmd, const std::string &path, bool redirect
 			DWORD readBytes;
 			std::array<char, 65536> buffer;
 			while( ReadFile( mErrorRead, buffer.data(), static_cast<DWORD>(65536), &readBytes, nullptr ) && readBytes != 0 ) {
-				// copy the buffer into a string
-				std::string error( buffer.begin(), buffer.begin() + readBytes );
-				// add the string to the sync output
-				outputStr += error;
-				// push the string to the async queue
-				std::lock_guard<std::mutex> queueLock( mErrorQueueMutex );
-				bool wasEmpty = mErrorQueue.empty();
-				mErrorQueue.push( error );
-				if( wasEmpty ) {
-					std::lock_guard<std::mutex> queueEmptyLock( mErrorQueueEmptyMutex );
-					mIsErrorQueueEmpty = false;
-				}
+				// add the chunk to the sync output
+				appendBounded( outputStr, buffer.data(), readBytes, mSyncOutputLimit );
+				// and to the async ring
+				mErrorRing.write( buffer.data(), readBytes );
 			}
 			// send back the sync output
 			errorPromise.set_value( outputStr );
@@ -217,63 +538,271 @@ Process::Process( const std::string &cmd, const std::string &path, bool redirect
 	}
 
 #else
+	mInputWrite = -1;
+	mPid = -1;
+	mOpenPipes = 0;
+	mExited = false;
+	mExitCode = -1;
+	mOutputPipe = 0;
+	mErrorPipe = 0;
+	mProcessRunning = false;
+
+	ManagedDescriptor outputRead;
+	ManagedDescriptor outputWrite;
+	ManagedDescriptor errorRead;
+	ManagedDescriptor errorWrite;
+	ManagedDescriptor inputRead;
+	ManagedDescriptor inputWrite;
+
+	// Create the pipes
+	if( redirectOutput && ! createPipe( outputRead, outputWrite ) ) {
+		throw ProcessExc( "Failed Creating StdOut Pipe" );
+	}
+	if( redirectError && ! createPipe( errorRead, errorWrite ) ) {
+		throw ProcessExc( "Failed Creating StdErr Pipe" );
+	}
+	if( redirectInput && ! createPipe( inputRead, inputWrite ) ) {
+		throw ProcessExc( "Failed Creating StdIn Pipe" );
+	}
+
+	// Map the child ends of the pipes to the standard streams of the new process
+	posix_spawn_file_actions_t fileActions;
+	posix_spawn_file_actions_init( &fileActions );
+	if( redirectOutput ) {
+		posix_spawn_file_actions_adddup2( &fileActions, outputWrite, STDOUT_FILENO );
+	}
+	if( redirectError ) {
+		posix_spawn_file_actions_adddup2( &fileActions, errorWrite, STDERR_FILENO );
+	}
+	else if( mergeError && redirectOutput ) {
+		posix_spawn_file_actions_adddup2( &fileActions, outputWrite, STDERR_FILENO );
+	}
+	if( redirectInput ) {
+		posix_spawn_file_actions_adddup2( &fileActions, inputRead, STDIN_FILENO );
+	}
+
+	// posix_spawn has no portable way of changing the working directory so let the shell do it
+	std::string shellCommand = cmd;
+	if( ! path.empty() ) {
+		shellCommand = "cd " + quoteArgument( path ) + " && " + cmd;
+	}
+	std::string shellPath = "/bin/sh";
+	std::string shellFlag = "-c";
+	char* argv[] = { &shellPath[0], &shellFlag[0], &shellCommand[0], nullptr };
+	
+	// Give the process its own group so kill() can take down the children it starts as well
+	posix_spawnattr_t spawnAttributes;
+	posix_spawnattr_init( &spawnAttributes );
+	posix_spawnattr_setflags( &spawnAttributes, POSIX_SPAWN_SETPGROUP );
+	posix_spawnattr_setpgroup( &spawnAttributes, 0 );
+
+	// Initialize the new process
+	pid_t pid;
+	int spawnResult = cmd.empty() ? EINVAL : posix_spawn( &pid, shellPath.c_str(), &fileActions, &spawnAttributes, argv, environ );
+	posix_spawnattr_destroy( &spawnAttributes );
+	posix_spawn_file_actions_destroy( &fileActions );
+	if( spawnResult != 0 ) {
+		throw ProcessExc( "Failed Creating Process" );
+	}
+	mPid = static_cast<int>( pid );
+	mProcessRunning = true;
+
+	// Close the child ends of the pipes now that they've been inherited
+	outputWrite.reset( -1 );
+	errorWrite.reset( -1 );
+	inputRead.reset( -1 );
+
+	if( redirectInput ) {
+	#if defined( F_SETNOSIGPIPE )
+		// a write to the stdin of a process that already exited fails instead of raising SIGPIPE
+		fcntl( inputWrite, F_SETNOSIGPIPE, 1 );
+	#endif
+		mInputWrite = inputWrite.detach();
+	}
+	mOpenPipes = ( redirectOutput ? 1 : 0 ) + ( redirectError ? 1 : 0 );
+
+	// the exit is noticed even if a process started by the child keeps the pipes open, otherwise it is when they're closed
+	int exitFd = openExitDescriptor( pid );
+	if( exitFd != -1 ) {
+		auto exitPromise = std::make_shared<std::promise<void>>();
+		mExitFuture = exitPromise->get_future();
+		PipeReader::instance().add( exitFd, nullptr, [this, exitPromise]() {
+			onExited();
+			exitPromise->set_value();
+		} );
+	}
+
+	// Hand the read ends to the shared reader thread
+	if( redirectOutput ) {
+		auto outputPromise = std::make_shared<std::promise<std::string>>();
+		auto outputStr = std::make_shared<std::string>();
+		mOutputFuture = outputPromise->get_future();
+		mOutputPipe = PipeReader::instance().add( outputRead.detach(), 
+			[this, outputStr]( const char* data, size_t size ) {
+				// add the chunk to the sync output
+				appendBounded( *outputStr, data, size, mSyncOutputLimit );
+				// and to the output handler or the async ring
+				pushOutput( data, size );
+			},
+			[this, outputStr, outputPromise]() {
+				onPipeClosed();
+				// send back the sync output
+				outputPromise->set_value( std::move( *outputStr ) );
+			} );
+	}
+	if( redirectError ) {
+		auto errorPromise = std::make_shared<std::promise<std::string>>();
+		auto errorStr = std::make_shared<std::string>();
+		mErrorFuture = errorPromise->get_future();
+		mErrorPipe = PipeReader::instance().add( errorRead.detach(), 
+			[this, errorStr]( const char* data, size_t size ) {
+				// add the chunk to the sync output
+				appendBounded( *errorStr, data, size, mSyncOutputLimit );
+				// and to the async ring
+				mErrorRing.write( data, size );
+			},
+			[this, errorStr, errorPromise]() {
+				onPipeClosed();
+				// send back the sync output
+				errorPromise->set_value( std::move( *errorStr ) );
+			} );
+	}
 #endif
 }
 
+#if ! ( defined(_WIN32) || defined(__WIN32__) || defined(WIN32) )
+void Process::onPipeClosed()
+{
+	// once every redirected stream is closed the child has most likely exited, try reaping it from here
+	if( --mOpenPipes == 0 ) {
+		onExited();
+	}
+}
+
+void Process::onExited()
+{
+	// the exit notification and the closing of the pipes can both try, only one reaps the child
+	int status;
+	if( ! mExited && waitpid( static_cast<pid_t>( mPid ), &status, WNOHANG ) == static_cast<pid_t>( mPid ) ) {
+		mExitCode = decodeExitStatus( status );
+		mExited = true;
+	}
+}
+#endif
+
 Process::~Process()
 {
 	terminate();
 }
 
+bool Process::hasExited()
+{
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	return ! mProcessRunning || WaitForSingleObject( mProcess, 0 ) == WAIT_OBJECT_0;
+#else
+	if( mProcessRunning && ! mExited ) {
+		onExited();
+	}
+	return ! mProcessRunning || mExited;
+#endif
+}
+
 std::string Process::getOutputSync()
 {
 	mOutputFuture.wait();
-	return mOutputFuture.get();
+	std::string output = mOutputFuture.get();
+	if( mSyncOutputLimit && output.size() > mSyncOutputLimit ) {
+		output.erase( 0, output.size() - mSyncOutputLimit );
+	}
+	return output;
 }
 std::string Process::getErrorSync()
 {
 	mErrorFuture.wait();
-	return mErrorFuture.get();
+	std::string error = mErrorFuture.get();
+	if( mSyncOutputLimit && error.size() > mSyncOutputLimit ) {
+		error.erase( 0, error.size() - mSyncOutputLimit );
+	}
+	return error;
 }
 
-std::string	Process::getOutputAsync()
-{
-	std::lock_guard<std::mutex> queueLock( mOutputQueueMutex );
-	if( ! mOutputQueue.empty() ) {
-		std::string output = mOutputQueue.front();
-		mOutputQueue.pop();
-		if( mOutputQueue.empty() ) {
-			std::lock_guard<std::mutex> queueEmptyLock( mOutputQueueEmptyMutex );
-			mIsOutputQueueEmpty = true;
+namespace {
+	std::string drainRing( runtime::RingBuffer &ring )
+	{
+		std::string result;
+		size_t size;
+		for( const char* data = ring.peek( &size ); size; data = ring.peek( &size ) ) {
+			result.append( data, size );
+			ring.consume( size );
 		}
-		return output;
+		return result;
 	}
-	return std::string();
+} // anonymous namespace
+
+std::string	Process::getOutputAsync()
+{
+	return drainRing( mOutputRing );
 }
 std::string	Process::getErrorAsync()
 {
-	std::lock_guard<std::mutex> queueLock( mErrorQueueMutex );
-	if( ! mErrorQueue.empty() ) {
-		std::string error = mErrorQueue.front();
-		mErrorQueue.pop();
-		if( mErrorQueue.empty() ) {
-			std::lock_guard<std::mutex> queueEmptyLock( mErrorQueueEmptyMutex );
-			mIsErrorQueueEmpty = true;
+	return drainRing( mErrorRing );
+}
+
+size_t Process::readOutputAsync( char* data, size_t size )
+{
+	return mOutputRing.read( data, size );
+}
+size_t Process::readErrorAsync( char* data, size_t size )
+{
+	return mErrorRing.read( data, size );
+}
+
+bool Process::isOutputAvailable() const
+{
+	return ! mOutputRing.empty();
+}
+bool Process::isErrorAvailable() const
+{
+	return ! mErrorRing.empty();
+}
+
+size_t Process::getOutputDroppedBytes() const
+{
+	return mOutputRing.getDroppedBytes();
+}
+size_t Process::getErrorDroppedBytes() const
+{
+	return mErrorRing.getDroppedBytes();
+}
+
+void Process::setOutputHandler( const std::function<void( const char*, size_t )> &handler )
+{
+	std::lock_guard<std::mutex> lock( mOutputHandlerMutex );
+	if( handler ) {
+		size_t size;
+		for( const char* data = mOutputRing.peek( &size ); size; data = mOutputRing.peek( &size ) ) {
+			handler( data, size );
+			mOutputRing.consume( size );
 		}
-		return error;
 	}
-	return std::string();
+	mOutputHandler = handler;
 }
 
-bool Process::isOutputAvailable()
+void Process::pushOutput( const char* data, size_t size )
 {
-	std::lock_guard<std::mutex> queueEmptyLock( mOutputQueueEmptyMutex );
-	return ! mIsOutputQueueEmpty;
+	// uncontended unless the handler is being replaced
+	std::lock_guard<std::mutex> lock( mOutputHandlerMutex );
+	if( mOutputHandler ) {
+		mOutputHandler( data, size );
+	}
+	else {
+		mOutputRing.write( data, size );
+	}
 }
-bool Process::isErrorAvailable()
+
+void Process::setSyncOutputLimit( size_t maxBytes )
 {
-	std::lock_guard<std::mutex> queueEmptyLock( mErrorQueueEmptyMutex );
-	return ! mIsErrorQueueEmpty;
+	mSyncOutputLimit = maxBytes;
 }
 
 bool Process::write( const std::string &cmd )
@@ -287,6 +816,9 @@ bool Process::write( const std::string &cmd )
     }
   }
 #else
+  if( mInputWrite != -1 ) {
+	return writeAll( mInputWrite, cmd.data(), cmd.length() );
+  }
 #endif
   return false;
 }
@@ -299,6 +831,27 @@ void Process::closeInput()
 		mInputWrite = nullptr;
 	}
 #else
+	if( mInputWrite != -1 ) {
+		::close( mInputWrite );
+		mInputWrite = -1;
+	}
+#endif
+}
+
+void Process::kill()
+{
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+	if( mProcessRunning ) {
+		if( ! mJob || ! TerminateJobObject( mJob, 1 ) ) {
+			TerminateProcess( mProcess, 1 );
+		}
+	}
+#else
+	if( mProcessRunning && ! mExited ) {
+		if( ::kill( -static_cast<pid_t>( mPid ), SIGKILL ) != 0 ) {
+			::kill( static_cast<pid_t>( mPid ), SIGKILL );
+		}
+	}
 #endif
 }
 
@@ -323,6 +876,38 @@ int16_t Process::terminate()
 		CloseHandle( mProcess );
 		mProcessRunning = false;
 	}
+#else
+	if( mProcessRunning ) {
+		// Once the child exited, stop waiting for the pipes a process it started may still hold
+		if( mExitFuture.valid() ) {
+			mExitFuture.wait();
+			if( mOutputPipe ) {
+				PipeReader::instance().close( mOutputPipe );
+			}
+			if( mErrorPipe ) {
+				PipeReader::instance().close( mErrorPipe );
+			}
+		}
+		// Wait for the reader thread to drain and close the pipes, it reaps the child when it can
+		if( mOutputFuture.valid() ) {
+			mOutputFuture.wait();
+		}
+		if( mErrorFuture.valid() ) {
+			mErrorFuture.wait();
+		}
+		// Otherwise wait for the child to exit
+		if( ! mExited ) {
+			int status;
+			pid_t result;
+			while( ( result = waitpid( static_cast<pid_t>( mPid ), &status, 0 ) ) < 0 && errno == EINTR );
+			if( result == static_cast<pid_t>( mPid ) ) {
+				mExitCode = decodeExitStatus( status );
+			}
+			mExited = true;
+		}
+		exitCode = static_cast<int16_t>( mExitCode );
+		mProcessRunning = false;
+	}
 #endif
 
 	// Join Threads
@@ -343,6 +928,10 @@ int16_t Process::terminate()
 		CloseHandle( mErrorRead );
 		mErrorRead = nullptr;
 	}
+	if( mJob ) {
+		CloseHandle( mJob );
+		mJob = nullptr;
+	}
 #endif
 
 	return exitCode;
@@ -0,0 +1,392 @@
+#include "runtime/SymbolIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+namespace {
+
+	//! Reads a little-endian value at offset, returns false past the end of data
+	template<typename T>
+	bool readValue( const std::vector<char> &data, uint64_t offset, T *value )
+	{
+		if( offset > data.size() || sizeof( T ) > data.size() - offset ) {
+			return false;
+		}
+		std::memcpy( value, data.data() + offset, sizeof( T ) );
+		return true;
+	}
+
+	//! Returns the nul-terminated string at offset, or an empty string past the end of data
+	std::string readString( const std::vector<char> &data, uint64_t offset, size_t maxSize = std::string::npos )
+	{
+		if( offset >= data.size() ) {
+			return std::string();
+		}
+		auto begin = data.data() + offset;
+		auto size = std::min<size_t>( maxSize, data.size() - offset );
+		return std::string( begin, std::find( begin, begin + size, '\0' ) );
+	}
+
+	int64_t getWriteTime( const ci::fs::path &path )
+	{
+		std::error_code errorCode;
+		auto time = fs::last_write_time( path, errorCode );
+		return errorCode ? 0 : static_cast<int64_t>( time.time_since_epoch().count() );
+	}
+
+	// https://docs.microsoft.com/en-us/windows/win32/debug/pe-format#coff-file-header-object-and-image
+	bool readCoffSymbols( const std::vector<char> &data, std::vector<std::string> *defined, std::vector<std::string> *weak, std::vector<std::string> *undefined )
+	{
+		uint16_t signature1 = 1, signature2 = 0;
+		readValue( data, 0, &signature1 );
+		readValue( data, 2, &signature2 );
+
+		bool bigObj = false;
+		uint32_t numSections = 0, symbolTable = 0, numSymbols = 0;
+		uint64_t sectionTable = 0;
+		if( signature1 == 0 && signature2 == 0xFFFF ) {
+			// anonymous objects are either /bigobj objects or /GL objects holding intermediate code
+			static const uint8_t bigObjClassId[16] = { 0xC7, 0xA1, 0xBA, 0xD1, 0xEE, 0xBA, 0xA9, 0x4B, 0xAF, 0x20, 0xFA, 0xF6, 0x6A, 0xA4, 0xDC, 0xB8 };
+			if( data.size() < 56 || std::memcmp( data.data() + 12, bigObjClassId, sizeof( bigObjClassId ) ) != 0 ) {
+				return false;
+			}
+			bigObj = true;
+			readValue( data, 44, &numSections );
+			readValue( data, 48, &symbolTable );
+			readValue( data, 52, &numSymbols );
+			sectionTable = 56;
+		}
+		else {
+			uint16_t machine = signature1, sections = 0, optionalHeaderSize = 0;
+			if( machine != 0x14C && machine != 0x8664 && machine != 0xAA64 && machine != 0x1C4 ) {
+				return false;
+			}
+			readValue( data, 2, &sections );
+			readValue( data, 8, &symbolTable );
+			readValue( data, 12, &numSymbols );
+			readValue( data, 16, &optionalHeaderSize );
+			numSections = sections;
+			sectionTable = 20 + optionalHeaderSize;
+		}
+
+		// inline functions and templates are emitted in COMDAT sections by every object using them
+		const uint32_t comdatFlag = 0x1000;
+		auto isComdatSection = [&]( int32_t section ) {
+			uint32_t characteristics = 0;
+			return section > 0 && static_cast<uint32_t>( section ) <= numSections && readValue( data, sectionTable + ( section - 1 ) * 40 + 36, &characteristics ) && ( characteristics & comdatFlag );
+		};
+
+		const uint64_t symbolSize = bigObj ? 20 : 18;
+		const uint64_t stringTable = symbolTable + numSymbols * symbolSize;
+		if( stringTable > data.size() ) {
+			return false;
+		}
+		for( uint32_t i = 0; i < numSymbols; ++i ) {
+			uint64_t symbol = symbolTable + i * symbolSize;
+			uint32_t value = 0;
+			int32_t section = 0;
+			uint8_t storageClass = 0, numAuxSymbols = 0;
+			readValue( data, symbol + 8, &value );
+			if( bigObj ) {
+				readValue( data, symbol + 12, &section );
+				readValue( data, symbol + 18, &storageClass );
+				readValue( data, symbol + 19, &numAuxSymbols );
+			}
+			else {
+				int16_t shortSection = 0;
+				readValue( data, symbol + 12, &shortSection );
+				section = shortSection;
+				readValue( data, symbol + 16, &storageClass );
+				readValue( data, symbol + 17, &numAuxSymbols );
+			}
+			i += numAuxSymbols;
+
+			const uint8_t externalClass = 2;
+			if( storageClass != externalClass ) {
+				continue;
+			}
+			// short names are stored inline, the others in the string table
+			uint32_t zeroes = 0, nameOffset = 0;
+			readValue( data, symbol, &zeroes );
+			readValue( data, symbol + 4, &nameOffset );
+			auto name = zeroes ? readString( data, symbol, 8 ) : readString( data, stringTable + nameOffset );
+			if( name.empty() ) {
+				continue;
+			}
+
+			if( section == 0 ) {
+				// a value means a common symbol
+				( value ? weak : undefined )->push_back( name );
+			}
+			else {
+				( isComdatSection( section ) ? weak : defined )->push_back( name );
+			}
+		}
+		return true;
+	}
+
+	// https://refspecs.linuxfoundation.org/elf/gabi4+/ch4.symtab.html
+	bool readElfSymbols( const std::vector<char> &data, std::vector<std::string> *defined, std::vector<std::string> *weak, std::vector<std::string> *undefined )
+	{
+		// little-endian objects only
+		if( data.size() < 64 || std::memcmp( data.data(), "\x7F" "ELF", 4 ) != 0 || data[5] != 1 ) {
+			return false;
+		}
+		bool is64 = data[4] == 2;
+
+		uint64_t sectionTable = 0;
+		uint16_t sectionSize = 0, numSections = 0;
+		if( is64 ) {
+			readValue( data, 0x28, &sectionTable );
+			readValue( data, 0x3A, &sectionSize );
+			readValue( data, 0x3C, &numSections );
+		}
+		else {
+			uint32_t sectionTable32 = 0;
+			readValue( data, 0x20, &sectionTable32 );
+			readValue( data, 0x2E, &sectionSize );
+			readValue( data, 0x30, &numSections );
+			sectionTable = sectionTable32;
+		}
+
+		// offset, size, linked section and entry size of a section header
+		auto readSection = [&]( uint64_t index, uint64_t *offset, uint64_t *size, uint32_t *link, uint64_t *entrySize ) {
+			uint64_t header = sectionTable + index * sectionSize;
+			if( is64 ) {
+				return readValue( data, header + 0x18, offset ) && readValue( data, header + 0x20, size ) && readValue( data, header + 0x28, link ) && readValue( data, header + 0x38, entrySize );
+			}
+			uint32_t offset32 = 0, size32 = 0, entrySize32 = 0;
+			bool valid = readValue( data, header + 0x10, &offset32 ) && readValue( data, header + 0x14, &size32 ) && readValue( data, header + 0x18, link ) && readValue( data, header + 0x24, &entrySize32 );
+			*offset = offset32;
+			*size = size32;
+			*entrySize = entrySize32;
+			return valid;
+		};
+
+		for( uint16_t i = 0; i < numSections; ++i ) {
+			const uint32_t symbolTableType = 2;
+			uint32_t type = 0;
+			if( ! readValue( data, sectionTable + i * sectionSize + 4, &type ) || type != symbolTableType ) {
+				continue;
+			}
+			uint64_t offset = 0, size = 0, entrySize = 0, stringTable = 0, stringTableSize = 0, unused = 0;
+			uint32_t link = 0, unusedLink = 0;
+			if( ! readSection( i, &offset, &size, &link, &entrySize ) || ! entrySize || ! readSection( link, &stringTable, &stringTableSize, &unusedLink, &unused ) ) {
+				return false;
+			}
+
+			// the first symbol is always empty
+			for( uint64_t symbol = offset + entrySize; symbol + entrySize <= offset + size; symbol += entrySize ) {
+				uint32_t nameOffset = 0;
+				uint8_t info = 0;
+				uint16_t section = 0;
+				readValue( data, symbol, &nameOffset );
+				readValue( data, symbol + ( is64 ? 4 : 12 ), &info );
+				readValue( data, symbol + ( is64 ? 6 : 14 ), &section );
+
+				const uint8_t globalBinding = 1, weakBinding = 2;
+				const uint16_t undefinedSection = 0, commonSection = 0xFFF2;
+				uint8_t binding = info >> 4;
+				if( binding != globalBinding && binding != weakBinding ) {
+					continue;
+				}
+				auto name = readString( data, stringTable + nameOffset );
+				if( name.empty() ) {
+					continue;
+				}
+
+				if( section == undefinedSection ) {
+					// weak references don't need a definition
+					if( binding == globalBinding ) {
+						undefined->push_back( name );
+					}
+				}
+				else {
+					// inline functions and templates are weak symbols in COMDAT groups
+					( binding == weakBinding || section == commonSection ? weak : defined )->push_back( name );
+				}
+			}
+		}
+		return true;
+	}
+
+} // anonymous namespace
+
+SymbolIndex& SymbolIndex::instance()
+{
+	static SymbolIndex index;
+	return index;
+}
+
+SymbolIndex::SymbolIndex()
+: mModified( false )
+{
+}
+
+bool SymbolIndex::readSymbols( const ci::fs::path &path, Object *object )
+{
+	object->defined.clear();
+	object->weak.clear();
+	object->undefined.clear();
+
+	std::ifstream file( path, std::ios::binary );
+	if( ! file ) {
+		return false;
+	}
+	std::vector<char> data( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>() );
+	return readElfSymbols( data, &object->defined, &object->weak, &object->undefined ) || readCoffSymbols( data, &object->defined, &object->weak, &object->undefined );
+}
+
+const SymbolIndex::Object& SymbolIndex::getObject( const ci::fs::path &path )
+{
+	std::error_code errorCode;
+	auto writeTime = getWriteTime( path );
+	auto size = static_cast<uint64_t>( fs::file_size( path, errorCode ) );
+	if( errorCode ) {
+		size = 0;
+	}
+
+	auto objectIt = mObjects.find( path );
+	if( objectIt == mObjects.end() || objectIt->second.writeTime != writeTime || objectIt->second.size != size ) {
+		Object object;
+		object.writeTime = writeTime;
+		object.size = size;
+		object.readable = readSymbols( path, &object );
+		objectIt = mObjects.insert_or_assign( path, std::move( object ) ).first;
+		mModified = true;
+	}
+	return objectIt->second;
+}
+
+bool SymbolIndex::getLinkClosure( const std::vector<ci::fs::path> &objects, const std::vector<ci::fs::path> &candidates, std::vector<ci::fs::path> *closure )
+{
+	closure->clear();
+
+	std::set<std::string> definedSymbols;
+	std::vector<std::string> unresolvedSymbols;
+	for( const auto &path : objects ) {
+		const auto &object = getObject( path );
+		if( ! object.readable ) {
+			return false;
+		}
+		definedSymbols.insert( object.defined.begin(), object.defined.end() );
+		definedSymbols.insert( object.weak.begin(), object.weak.end() );
+		unresolvedSymbols.insert( unresolvedSymbols.end(), object.undefined.begin(), object.undefined.end() );
+	}
+
+	// a regular definition is preferred over the objects that only carry an inline copy
+	std::vector<bool> included( candidates.size(), false );
+	std::map<std::string,size_t> definitions;
+	for( size_t i = 0; i < candidates.size(); ++i ) {
+		const auto &candidate = getObject( candidates[i] );
+		if( ! candidate.readable ) {
+			included[i] = true;
+			continue;
+		}
+		for( const auto &symbol : candidate.defined ) {
+			definitions.emplace( symbol, i );
+		}
+	}
+	for( size_t i = 0; i < candidates.size(); ++i ) {
+		for( const auto &symbol : getObject( candidates[i] ).weak ) {
+			definitions.emplace( symbol, i );
+		}
+	}
+
+	// pull in the definitions of the unresolved symbols until nothing new comes in. The others are left to the libraries.
+	while( ! unresolvedSymbols.empty() ) {
+		auto symbol = std::move( unresolvedSymbols.back() );
+		unresolvedSymbols.pop_back();
+		if( definedSymbols.count( symbol ) ) {
+			continue;
+		}
+		auto definition = definitions.find( symbol );
+		if( definition == definitions.end() || included[definition->second] ) {
+			continue;
+		}
+		included[definition->second] = true;
+		const auto &candidate = getObject( candidates[definition->second] );
+		definedSymbols.insert( candidate.defined.begin(), candidate.defined.end() );
+		definedSymbols.insert( candidate.weak.begin(), candidate.weak.end() );
+		unresolvedSymbols.insert( unresolvedSymbols.end(), candidate.undefined.begin(), candidate.undefined.end() );
+	}
+
+	for( size_t i = 0; i < candidates.size(); ++i ) {
+		if( included[i] ) {
+			closure->push_back( candidates[i] );
+		}
+	}
+	return true;
+}
+
+void SymbolIndex::load( const ci::fs::path &path )
+{
+	if( path == mPath ) {
+		return;
+	}
+	mPath = path;
+	mObjects.clear();
+	mModified = false;
+
+	// "o <write time> <size> <readable> <path>" followed by "d|w|u <symbol>" lines
+	std::ifstream file( path );
+	Object *object = nullptr;
+	for( string line; std::getline( file, line ); ) {
+		if( line.size() < 3 || line[1] != ' ' ) {
+			continue;
+		}
+		if( line[0] == 'o' ) {
+			std::istringstream lineStream( line.substr( 2 ) );
+			Object entry;
+			string objectPath;
+			lineStream >> entry.writeTime >> entry.size >> entry.readable;
+			object = lineStream && std::getline( lineStream >> std::ws, objectPath ) ? &( mObjects[objectPath] = entry ) : nullptr;
+		}
+		else if( object ) {
+			auto symbol = line.substr( 2 );
+			switch( line[0] ) {
+				case 'd': object->defined.push_back( symbol ); break;
+				case 'w': object->weak.push_back( symbol ); break;
+				case 'u': object->undefined.push_back( symbol ); break;
+			}
+		}
+	}
+}
+
+void SymbolIndex::save()
+{
+	if( ! mModified || mPath.empty() ) {
+		return;
+	}
+	std::error_code errorCode;
+	fs::create_directories( mPath.parent_path(), errorCode );
+	// symbols are written one per line, without flushing every line
+	std::ofstream file( mPath );
+	for( const auto &object : mObjects ) {
+		// objects deleted since aren't worth keeping
+		if( ! fs::exists( object.first, errorCode ) ) {
+			continue;
+		}
+		file << "o " << object.second.writeTime << " " << object.second.size << " " << object.second.readable << " " << object.first.string() << "\n";
+		for( const auto &symbol : object.second.defined ) {
+			file << "d " << symbol << "\n";
+		}
+		for( const auto &symbol : object.second.weak ) {
+			file << "w " << symbol << "\n";
+		}
+		for( const auto &symbol : object.second.undefined ) {
+			file << "u " << symbol << "\n";
+		}
+	}
+	mModified = false;
+}
+
+} // namespace runtime
@@ -0,0 +1,69 @@
+#include "runtime/UnityBuild.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+using namespace std;
+using namespace ci;
+
+namespace runtime {
+
+namespace {
+
+bool isExcluded( const ci::fs::path &source, const std::vector<ci::fs::path> &exclusions )
+{
+	return std::any_of( exclusions.begin(), exclusions.end(), [&source]( const ci::fs::path &exclusion ) {
+		return exclusion.has_parent_path() ? exclusion.lexically_normal() == source.lexically_normal() : exclusion == source.filename();
+	} );
+}
+
+//! Writes content to path unless it already holds it, so the file keeps its timestamp
+void writeIfChanged( const ci::fs::path &path, const std::string &content )
+{
+	std::ifstream inputFile( path, std::ios::binary );
+	std::stringstream current;
+	current << inputFile.rdbuf();
+	if( ! inputFile || current.str() != content ) {
+		inputFile.close();
+		std::ofstream outputFile( path, std::ios::binary );
+		outputFile << content;
+	}
+}
+
+}
+
+std::vector<ci::fs::path> generateUnitySources( const std::vector<ci::fs::path> &sources, const std::vector<ci::fs::path> &exclusions, size_t chunkSize, const ci::fs::path &directory, const std::string &name )
+{
+	std::vector<fs::path> translationUnits;
+	std::vector<fs::path> unitySources;
+	for( const auto &source : sources ) {
+		if( isExcluded( source, exclusions ) ) {
+			translationUnits.push_back( source );
+		}
+		else {
+			unitySources.push_back( source );
+		}
+	}
+
+	chunkSize = std::max<size_t>( chunkSize, 1 );
+	for( size_t first = 0, index = 0; first < unitySources.size(); first += chunkSize, ++index ) {
+		size_t last = std::min( first + chunkSize, unitySources.size() );
+		// a single source doesn't need a unity source
+		if( last - first == 1 ) {
+			translationUnits.push_back( unitySources[first] );
+			continue;
+		}
+
+		// quoted includes of each source are still looked up next to it
+		std::ostringstream content;
+		for( size_t i = first; i < last; ++i ) {
+			content << "#include \"" << unitySources[i].generic_string() << "\"" << endl;
+		}
+		auto unitySource = directory / ( name + "Unity" + to_string( index ) + ".cpp" );
+		writeIfChanged( unitySource, content.str() );
+		translationUnits.push_back( unitySource );
+	}
+	return translationUnits;
+}
+
+} // namespace runtime
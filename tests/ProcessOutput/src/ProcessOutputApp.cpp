@@ -0,0 +1,169 @@
+#include "cinder/app/App.h"
+#include "cinder/app/RendererGl.h"
+#include "cinder/gl/gl.h"
+#include "cinder/Utilities.h"
+
+#include "runtime/Process.h"
+#include "runtime/RingBuffer.h"
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <queue>
+
+using namespace ci;
+using namespace ci::app;
+using namespace std;
+
+// Benchmarks the Process output ring against the mutex guarded std::queue<std::string> it replaced,
+// by pushing a large verbose build log (/showIncludes output) from a producer thread in 64KB chunks.
+
+namespace {
+
+//! Replica of the previous Process output queue: one std::string per chunk and two locks on each side
+class MutexChunkQueue {
+public:
+	void push( const char* data, size_t size )
+	{
+		std::string output( data, data + size );
+		std::lock_guard<std::mutex> queueLock( mQueueMutex );
+		bool wasEmpty = mQueue.empty();
+		mQueue.push( output );
+		if( wasEmpty ) {
+			std::lock_guard<std::mutex> queueEmptyLock( mQueueEmptyMutex );
+			mIsQueueEmpty = false;
+		}
+	}
+	bool isAvailable()
+	{
+		std::lock_guard<std::mutex> queueEmptyLock( mQueueEmptyMutex );
+		return ! mIsQueueEmpty;
+	}
+	std::string pop()
+	{
+		std::lock_guard<std::mutex> queueLock( mQueueMutex );
+		if( ! mQueue.empty() ) {
+			std::string output = mQueue.front();
+			mQueue.pop();
+			if( mQueue.empty() ) {
+				std::lock_guard<std::mutex> queueEmptyLock( mQueueEmptyMutex );
+				mIsQueueEmpty = true;
+			}
+			return output;
+		}
+		return std::string();
+	}
+protected:
+	bool					mIsQueueEmpty = true;
+	std::mutex				mQueueMutex;
+	std::mutex				mQueueEmptyMutex;
+	std::queue<std::string>	mQueue;
+};
+
+std::string generateShowIncludesLog( size_t translationUnits, size_t includesPerUnit )
+{
+	std::string log;
+	for( size_t tu = 0; tu < translationUnits; ++tu ) {
+		log += "Module" + to_string( tu ) + ".cpp\n";
+		for( size_t inc = 0; inc < includesPerUnit; ++inc ) {
+			log += "Note: including file:   " + string( inc % 8, ' ' ) + "C:\\Libraries\\Cinder\\include\\cinder\\Header" + to_string( inc ) + ".h\n";
+		}
+	}
+	return log;
+}
+
+template<typename PushFn, typename DrainFn>
+double measure( const std::string &log, const PushFn &push, const DrainFn &drain )
+{
+	const size_t chunkSize = 65536;
+	auto start = chrono::steady_clock::now();
+	std::thread producer( [&]() {
+		for( size_t offset = 0; offset < log.size(); offset += chunkSize ) {
+			push( log.data() + offset, std::min( chunkSize, log.size() - offset ) );
+		}
+	} );
+	size_t received = 0;
+	while( received < log.size() ) {
+		received += drain();
+	}
+	producer.join();
+	return chrono::duration<double, milli>( chrono::steady_clock::now() - start ).count();
+}
+
+} // anonymous namespace
+
+class ProcessOutputApp : public App {
+public:
+	void setup() override;
+	void draw() override;
+
+	std::vector<std::string> mResults;
+};
+
+void ProcessOutputApp::setup()
+{
+	const size_t iterations = 5;
+	auto log = generateShowIncludesLog( 200, 2000 );
+	mResults.push_back( "log size: " + to_string( log.size() / ( 1024 * 1024 ) ) + "MB, " + to_string( iterations ) + " iterations" );
+
+	double queueTime = 0.0;
+	for( size_t i = 0; i < iterations; ++i ) {
+		MutexChunkQueue queue;
+		queueTime += measure( log,
+			[&]( const char* data, size_t size ) { queue.push( data, size ); },
+			[&]() { return queue.isAvailable() ? queue.pop().size() : 0; } );
+	}
+	mResults.push_back( "std::queue<std::string>: " + to_string( queueTime / iterations ) + "ms" );
+
+	double ringTime = 0.0;
+	std::vector<char> buffer( 65536 );
+	for( size_t i = 0; i < iterations; ++i ) {
+		rt::RingBuffer ring( 1 << 20, rt::RingBuffer::OverflowPolicy::BLOCK );
+		ringTime += measure( log,
+			[&]( const char* data, size_t size ) { ring.write( data, size ); },
+			[&]() { return ring.read( buffer.data(), buffer.size() ); } );
+	}
+	mResults.push_back( "rt::RingBuffer: " + to_string( ringTime / iterations ) + "ms" );
+
+	// end to end through a real process
+	auto logPath = getTemporaryDirectory() / "rt_show_includes.log";
+	{
+		std::ofstream logFile( logPath, std::ios::binary );
+		logFile << log;
+	}
+	auto start = chrono::steady_clock::now();
+#if defined( CINDER_MSW )
+	Process process( "cmd /c type \"" + logPath.string() + "\"" );
+#else
+	Process process( "cat '" + logPath.string() + "'" );
+#endif
+	size_t received = 0;
+	// stop polling if the child exits early, terminate() then reads what it wrote last into the ring
+	while( received + process.getOutputDroppedBytes() < log.size() && ! process.hasExited() ) {
+		received += process.readOutputAsync( buffer.data(), buffer.size() );
+	}
+	process.terminate();
+	while( size_t readBytes = process.readOutputAsync( buffer.data(), buffer.size() ) ) {
+		received += readBytes;
+	}
+	double processTime = chrono::duration<double, milli>( chrono::steady_clock::now() - start ).count();
+	mResults.push_back( "Process: " + to_string( processTime ) + "ms, " + to_string( received ) + " bytes received, " + to_string( process.getOutputDroppedBytes() ) + " bytes dropped" );
+	fs::remove( logPath );
+
+	for( const auto &result : mResults ) {
+		console() << result << endl;
+	}
+}
+
+void ProcessOutputApp::draw()
+{
+	gl::clear();
+
+	vec2 position( 20.0f );
+	for( const auto &result : mResults ) {
+		gl::drawString( result, position );
+		position.y += 20.0f;
+	}
+}
+
+CINDER_APP( ProcessOutputApp, RendererGl() )
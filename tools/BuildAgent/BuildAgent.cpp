@@ -0,0 +1,469 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Reference build agent compiling preprocessed translation units for Runtime, and the client Runtime runs to send them.
+//
+//   rt-build-agent serve --compiler <compiler> [--port 9876] [--bind 127.0.0.1]
+//   rt-build-agent compile <host:port> <input> <output> [--timeout <ms>] [--compile-timeout <ms>] -- <arguments>
+//
+// A request is the line "@rt compile <name length> <arguments length> <input length>" followed by the name of the
+// object, the compiler arguments separated by null characters and the preprocessed source. "{input}" and "{output}"
+// in the arguments stand for the paths of the source and of the object on the agent. The response is the line
+// "@rt object <exit code> <output length> <object length>" followed by the compiler output and the object.
+//
+// The client prints the compiler output and writes the object. If the agent can't be reached it prints
+// "@rt agent unavailable <host:port>" and exits with 75 so that the job compiles locally instead. That's also the case
+// when connecting, sending or receiving stalls for longer than --timeout (1 second by default), or when the object
+// doesn't start coming back within --compile-timeout (2 minutes by default).
+//
+// Build with "c++ -std=c++17 -O2 BuildAgent.cpp -o rt-build-agent -pthread", or "cl /std:c++17 /EHsc /O2 BuildAgent.cpp ws2_32.lib".
+// The agent runs any arguments it receives with its compiler: only expose it to trusted machines.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined( _WIN32 )
+	#if ! defined( WIN32_LEAN_AND_MEAN )
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	#pragma comment( lib, "ws2_32.lib" )
+	using Socket = SOCKET;
+	#define popen _popen
+	#define pclose _pclose
+#else
+	#include <fcntl.h>
+	#include <netdb.h>
+	#include <signal.h>
+	#include <sys/select.h>
+	#include <sys/socket.h>
+	#include <sys/wait.h>
+	#include <unistd.h>
+	using Socket = int;
+	const Socket INVALID_SOCKET = -1;
+	inline int closesocket( Socket socket ) { return close( socket ); }
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const int sAgentUnavailableStatus = 75;
+const uint64_t sMaxLength = 1ull << 30;
+
+bool sendAll( Socket socket, const char* data, size_t size )
+{
+	while( size > 0 ) {
+		auto sent = send( socket, data, static_cast<int>( std::min<size_t>( size, 1 << 20 ) ), 0 );
+		if( sent <= 0 ) {
+			return false;
+		}
+		data += sent;
+		size -= static_cast<size_t>( sent );
+	}
+	return true;
+}
+
+bool receiveAll( Socket socket, char* data, size_t size )
+{
+	while( size > 0 ) {
+		auto received = recv( socket, data, static_cast<int>( std::min<size_t>( size, 1 << 20 ) ), 0 );
+		if( received <= 0 ) {
+			return false;
+		}
+		data += received;
+		size -= static_cast<size_t>( received );
+	}
+	return true;
+}
+
+bool receiveLine( Socket socket, std::string *line )
+{
+	line->clear();
+	char c;
+	while( line->size() < 256 ) {
+		if( ! receiveAll( socket, &c, 1 ) ) {
+			return false;
+		}
+		if( c == '\n' ) {
+			return true;
+		}
+		*line += c;
+	}
+	return false;
+}
+
+//! Reads the numbers following prefix in line
+bool parseHeader( const std::string &line, const std::string &prefix, int64_t *numbers, size_t count )
+{
+	if( line.compare( 0, prefix.size(), prefix ) != 0 ) {
+		return false;
+	}
+	std::istringstream stream( line.substr( prefix.size() ) );
+	for( size_t i = 0; i < count; ++i ) {
+		if( ! ( stream >> numbers[i] ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool readFile( const fs::path &path, std::string *content )
+{
+	std::ifstream file( path, std::ios::binary );
+	if( ! file ) {
+		return false;
+	}
+	std::ostringstream stream;
+	stream << file.rdbuf();
+	*content = stream.str();
+	return true;
+}
+
+bool writeFile( const fs::path &path, const std::string &content )
+{
+	std::ofstream file( path, std::ios::binary );
+	file.write( content.data(), content.size() );
+	return static_cast<bool>( file );
+}
+
+//! Quotes argument for the shell popen runs the compiler with
+std::string quoteArgument( const std::string &argument )
+{
+#if defined( _WIN32 )
+	std::string quoted = "\"";
+	size_t backslashes = 0;
+	for( char c : argument ) {
+		if( c == '\\' ) {
+			++backslashes;
+			continue;
+		}
+		// backslashes are only special right before a quote
+		quoted.append( c == '"' ? backslashes * 2 + 1 : backslashes, '\\' );
+		backslashes = 0;
+		quoted += c;
+	}
+	quoted.append( backslashes * 2, '\\' );
+	return quoted + "\"";
+#else
+	std::string quoted = "'";
+	for( char c : argument ) {
+		quoted += c == '\'' ? std::string( "'\\''" ) : std::string( 1, c );
+	}
+	return quoted + "'";
+#endif
+}
+
+void replaceAll( std::string *str, const std::string &from, const std::string &to )
+{
+	for( size_t pos = str->find( from ); pos != std::string::npos; pos = str->find( from, pos + to.size() ) ) {
+		str->replace( pos, from.size(), to );
+	}
+}
+
+//! Compiles one request of the connection and sends the object back
+void serveConnection( Socket socket, const std::string &compiler, const fs::path &workDirectory )
+{
+	static std::atomic<uint64_t> sNextJob( 0 );
+
+	std::string line;
+	int64_t lengths[3];
+	if( ! receiveLine( socket, &line ) || ! parseHeader( line, "@rt compile ", lengths, 3 ) ||
+		lengths[0] <= 0 || lengths[0] > 255 || lengths[1] < 0 || lengths[2] < 0 || static_cast<uint64_t>( lengths[1] ) > sMaxLength || static_cast<uint64_t>( lengths[2] ) > sMaxLength ) {
+		closesocket( socket );
+		return;
+	}
+	std::string name( static_cast<size_t>( lengths[0] ), '\0' ), arguments( static_cast<size_t>( lengths[1] ), '\0' ), input( static_cast<size_t>( lengths[2] ), '\0' );
+	if( ! receiveAll( socket, &name[0], name.size() ) || ! receiveAll( socket, &arguments[0], arguments.size() ) || ! receiveAll( socket, &input[0], input.size() )
+		|| name.find_first_of( "/\\:" ) != std::string::npos || name == "." || name == ".." ) {
+		closesocket( socket );
+		return;
+	}
+
+	// every job gets its own directory, the object keeps the name it has on the client
+	auto jobDirectory = workDirectory / std::to_string( sNextJob++ );
+	std::error_code errorCode;
+	fs::create_directories( jobDirectory, errorCode );
+	auto inputPath = jobDirectory / ( fs::path( name ).stem().string() + ".i" );
+	auto outputPath = jobDirectory / name;
+	writeFile( inputPath, input );
+
+	std::string command = quoteArgument( compiler );
+	std::istringstream argumentStream( arguments );
+	for( std::string argument; std::getline( argumentStream, argument, '\0' ); ) {
+		replaceAll( &argument, "{input}", inputPath.string() );
+		replaceAll( &argument, "{output}", outputPath.string() );
+		command += " " + quoteArgument( argument );
+	}
+	command += " 2>&1";
+#if defined( _WIN32 )
+	// cmd strips the outer quotes of the command line
+	command = "\"" + command + "\"";
+#endif
+
+	std::string output;
+	int status = 1;
+	if( FILE* pipe = popen( command.c_str(), "r" ) ) {
+		char buffer[4096];
+		size_t size;
+		while( ( size = fread( buffer, 1, sizeof( buffer ), pipe ) ) > 0 ) {
+			output.append( buffer, size );
+		}
+		status = pclose( pipe );
+	#if ! defined( _WIN32 )
+		status = WIFEXITED( status ) ? WEXITSTATUS( status ) : 1;
+	#endif
+	}
+	else {
+		output = "rt-build-agent: failed to run " + compiler + "\n";
+	}
+
+	std::string object;
+	if( status == 0 && ! readFile( outputPath, &object ) ) {
+		output += "rt-build-agent: error: " + name + " wasn't written by the compiler\n";
+		status = 1;
+	}
+	fs::remove_all( jobDirectory, errorCode );
+
+	std::cout << name << ": " << status << std::endl;
+	auto header = "@rt object " + std::to_string( status ) + " " + std::to_string( output.size() ) + " " + std::to_string( object.size() ) + "\n";
+	sendAll( socket, header.data(), header.size() ) && sendAll( socket, output.data(), output.size() ) && sendAll( socket, object.data(), object.size() );
+	closesocket( socket );
+}
+
+int serve( const std::string &bindAddress, const std::string &port, const std::string &compiler )
+{
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	addrinfo* addresses = nullptr;
+	if( getaddrinfo( bindAddress.c_str(), port.c_str(), &hints, &addresses ) != 0 || ! addresses ) {
+		std::cerr << "rt-build-agent: can't resolve " << bindAddress << ":" << port << std::endl;
+		return 1;
+	}
+	Socket listener = socket( addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol );
+	int reuse = 1;
+	setsockopt( listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>( &reuse ), sizeof( reuse ) );
+	if( listener == INVALID_SOCKET || bind( listener, addresses->ai_addr, static_cast<int>( addresses->ai_addrlen ) ) != 0 || listen( listener, 64 ) != 0 ) {
+		std::cerr << "rt-build-agent: can't listen on " << bindAddress << ":" << port << std::endl;
+		freeaddrinfo( addresses );
+		return 1;
+	}
+	freeaddrinfo( addresses );
+
+	auto workDirectory = fs::temp_directory_path() / ( "rt-build-agent-" + port );
+	std::cout << "rt-build-agent: compiling with " << compiler << " on " << bindAddress << ":" << port << std::endl;
+	while( true ) {
+		Socket connection = accept( listener, nullptr, nullptr );
+		if( connection != INVALID_SOCKET ) {
+			std::thread( serveConnection, connection, compiler, workDirectory ).detach();
+		}
+	}
+}
+
+//! Makes send() or recv() on socket fail once they wait for more than timeout milliseconds, option is SO_SNDTIMEO or SO_RCVTIMEO
+bool setTimeout( Socket socket, int option, int timeout )
+{
+#if defined( _WIN32 )
+	DWORD time = static_cast<DWORD>( timeout );
+#else
+	timeval time = { timeout / 1000, ( timeout % 1000 ) * 1000 };
+#endif
+	return setsockopt( socket, SOL_SOCKET, option, reinterpret_cast<const char*>( &time ), sizeof( time ) ) == 0;
+}
+
+//! Connects to host:port, giving up after timeout milliseconds
+Socket connectTo( const std::string &address, int timeout )
+{
+	auto separator = address.rfind( ':' );
+	if( separator == std::string::npos ) {
+		return INVALID_SOCKET;
+	}
+	auto host = address.substr( 0, separator );
+	auto port = address.substr( separator + 1 );
+
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo* addresses = nullptr;
+	if( getaddrinfo( host.c_str(), port.c_str(), &hints, &addresses ) != 0 ) {
+		return INVALID_SOCKET;
+	}
+	Socket result = INVALID_SOCKET;
+	for( auto info = addresses; info && result == INVALID_SOCKET; info = info->ai_next ) {
+		Socket candidate = socket( info->ai_family, info->ai_socktype, info->ai_protocol );
+		if( candidate == INVALID_SOCKET ) {
+			continue;
+		}
+		// non-blocking while connecting so that an unreachable agent doesn't hold the job
+	#if defined( _WIN32 )
+		u_long nonBlocking = 1;
+		ioctlsocket( candidate, FIONBIO, &nonBlocking );
+	#else
+		fcntl( candidate, F_SETFL, fcntl( candidate, F_GETFL ) | O_NONBLOCK );
+	#endif
+		connect( candidate, info->ai_addr, static_cast<int>( info->ai_addrlen ) );
+		fd_set writable, failed;
+		FD_ZERO( &writable );
+		FD_ZERO( &failed );
+		FD_SET( candidate, &writable );
+		FD_SET( candidate, &failed );
+		timeval time = { timeout / 1000, ( timeout % 1000 ) * 1000 };
+		int error = 1;
+		socklen_t errorSize = sizeof( error );
+		if( select( static_cast<int>( candidate + 1 ), nullptr, &writable, &failed, &time ) == 1 && FD_ISSET( candidate, &writable )
+			&& getsockopt( candidate, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>( &error ), &errorSize ) == 0 && error == 0 ) {
+		#if defined( _WIN32 )
+			nonBlocking = 0;
+			ioctlsocket( candidate, FIONBIO, &nonBlocking );
+		#else
+			fcntl( candidate, F_SETFL, fcntl( candidate, F_GETFL ) & ~O_NONBLOCK );
+		#endif
+			result = candidate;
+		}
+		else {
+			closesocket( candidate );
+		}
+	}
+	freeaddrinfo( addresses );
+	return result;
+}
+
+int compile( const std::string &address, const fs::path &inputPath, const fs::path &outputPath, const std::vector<std::string> &arguments, int timeout, int compileTimeout )
+{
+	std::string input;
+	if( ! readFile( inputPath, &input ) ) {
+		std::cout << "rt-build-agent: error: can't read " << inputPath.string() << std::endl;
+		return 1;
+	}
+	std::string joinedArguments;
+	for( size_t i = 0; i < arguments.size(); ++i ) {
+		joinedArguments += ( i ? std::string( 1, '\0' ) : std::string() ) + arguments[i];
+	}
+	auto name = outputPath.filename().string();
+
+	auto unavailable = [&address]() {
+		std::cout << "@rt agent unavailable " << address << std::endl;
+		return sAgentUnavailableStatus;
+	};
+
+	// a stalled agent is as good as an unreachable one, the job shouldn't wait for it forever
+	Socket socket = connectTo( address, timeout );
+	if( socket == INVALID_SOCKET || ! setTimeout( socket, SO_SNDTIMEO, timeout ) || ! setTimeout( socket, SO_RCVTIMEO, compileTimeout ) ) {
+		if( socket != INVALID_SOCKET ) {
+			closesocket( socket );
+		}
+		return unavailable();
+	}
+	auto header = "@rt compile " + std::to_string( name.size() ) + " " + std::to_string( joinedArguments.size() ) + " " + std::to_string( input.size() ) + "\n";
+	std::string line;
+	int64_t response[3];
+	// nothing comes back while the agent compiles, once the response started the rest is only allowed the usual timeout
+	if( ! sendAll( socket, header.data(), header.size() ) || ! sendAll( socket, name.data(), name.size() ) || ! sendAll( socket, joinedArguments.data(), joinedArguments.size() ) || ! sendAll( socket, input.data(), input.size() )
+		|| ! receiveLine( socket, &line ) || ! parseHeader( line, "@rt object ", response, 3 ) || response[1] < 0 || response[2] < 0 || static_cast<uint64_t>( response[1] ) > sMaxLength || static_cast<uint64_t>( response[2] ) > sMaxLength
+		|| ! setTimeout( socket, SO_RCVTIMEO, timeout ) ) {
+		closesocket( socket );
+		return unavailable();
+	}
+	std::string output( static_cast<size_t>( response[1] ), '\0' ), object( static_cast<size_t>( response[2] ), '\0' );
+	bool received = receiveAll( socket, &output[0], output.size() ) && receiveAll( socket, &object[0], object.size() );
+	closesocket( socket );
+	if( ! received ) {
+		return unavailable();
+	}
+
+	// the diagnostics are parsed by Runtime as if the compiler ran locally
+	std::cout << output << std::flush;
+	int status = static_cast<int>( response[0] );
+	if( status == 0 ) {
+		// written next to its final name first so that a failure never leaves a partial object
+		auto temporaryPath = outputPath;
+		temporaryPath += ".tmp";
+		std::error_code errorCode;
+		bool written = writeFile( temporaryPath, object );
+		if( written ) {
+			fs::rename( temporaryPath, outputPath, errorCode );
+		}
+		if( ! written || errorCode ) {
+			std::cout << "rt-build-agent: error: can't write " << outputPath.string() << std::endl;
+			return 1;
+		}
+	}
+	// the agent's own status can't be mistaken for an unreachable agent
+	return status == sAgentUnavailableStatus ? 1 : status;
+}
+
+int usage()
+{
+	std::cerr << "usage: rt-build-agent serve --compiler <compiler> [--port 9876] [--bind 127.0.0.1]" << std::endl;
+	std::cerr << "       rt-build-agent compile <host:port> <input> <output> [--timeout <ms>] [--compile-timeout <ms>] -- <arguments>" << std::endl;
+	return 2;
+}
+
+} // anonymous namespace
+
+int main( int argc, char* argv[] )
+{
+#if defined( _WIN32 )
+	WSADATA data;
+	WSAStartup( MAKEWORD( 2, 2 ), &data );
+#else
+	// a client closing its connection early shouldn't take the agent down
+	signal( SIGPIPE, SIG_IGN );
+#endif
+
+	std::vector<std::string> args( argv + 1, argv + argc );
+	if( args.size() >= 1 && args[0] == "serve" ) {
+		std::string port = "9876", bindAddress = "127.0.0.1", compiler;
+		for( size_t i = 1; i + 1 < args.size(); i += 2 ) {
+			if( args[i] == "--port" ) port = args[i + 1];
+			else if( args[i] == "--bind" ) bindAddress = args[i + 1];
+			else if( args[i] == "--compiler" ) compiler = args[i + 1];
+			else return usage();
+		}
+		return compiler.empty() ? usage() : serve( bindAddress, port, compiler );
+	}
+	else if( args.size() >= 5 && args[0] == "compile" ) {
+		int timeout = 1000, compileTimeout = 120000;
+		size_t i = 4;
+		for( ; i < args.size() && args[i] != "--"; i += 2 ) {
+			if( args[i] == "--timeout" && i + 1 < args.size() ) timeout = std::atoi( args[i + 1].c_str() );
+			else if( args[i] == "--compile-timeout" && i + 1 < args.size() ) compileTimeout = std::atoi( args[i + 1].c_str() );
+			else return usage();
+		}
+		if( i == args.size() ) {
+			return usage();
+		}
+		return compile( args[1], args[2], args[3], std::vector<std::string>( args.begin() + i + 1, args.end() ), timeout, compileTimeout );
+	}
+	return usage();
+}
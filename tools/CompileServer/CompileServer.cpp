@@ -0,0 +1,147 @@
+/*
+ Copyright (c) 2017, Simon Geilfus
+ All rights reserved.
+
+ This code is designed for use with the Cinder C++ library, http://libcinder.org
+ Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+ the following conditions are met:
+    * Redistributions of source code must retain the above copyright notice, this list of conditions and
+	the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+	the following disclaimer in the documentation and/or other materials provided with the distribution.
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+ WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Reference compile server for Runtime. It speaks the protocol of rt::Compiler::setCompileServer() and runs every job
+// with the shell, which is what a worker does without a server. A real server would keep the compiler and its parsed
+// headers in memory instead; this one is a starting point and a way to try the protocol.
+//
+//   rt-compile-server [--exit-during-job <n>] [--exit-before-ready]
+//
+// It prints "@rt ready", then reads jobs from its input until it is closed. A job is the line
+// "@rt job <name length> <name>" followed by a line holding the command to run. The answer is the line
+// "@rt begin <name length> <name>", the output of the command, then "@rt end <name length> <name> <exit code>".
+//
+// --exit-during-job exits after printing the begin marker of the nth job, Runtime then fails that job and starts a
+// new server. --exit-before-ready exits without accepting jobs, Runtime then runs the compiler directly again.
+//
+// Build with "c++ -std=c++17 -O2 CompileServer.cpp -o rt-compile-server", or "cl /std:c++17 /EHsc /O2 CompileServer.cpp".
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined( _WIN32 )
+	#define popen _popen
+	#define pclose _pclose
+#else
+	#include <sys/wait.h>
+#endif
+
+namespace {
+
+//! Reads "@rt job <length> <name>" and the command line following it, returns false once the input is closed
+bool readJob( std::string *name, std::string *command )
+{
+	const std::string prefix = "@rt job ";
+	std::string line;
+	while( std::getline( std::cin, line ) ) {
+		if( line.compare( 0, prefix.size(), prefix ) != 0 ) {
+			std::cout << "rt-compile-server: ignoring \"" << line << "\"" << std::endl;
+			continue;
+		}
+
+		// the name is length-prefixed so it can contain anything, including line breaks
+		size_t separator = line.find( ' ', prefix.size() );
+		size_t length = static_cast<size_t>( std::strtoull( line.c_str() + prefix.size(), nullptr, 10 ) );
+		if( separator == std::string::npos ) {
+			continue;
+		}
+		*name = line.substr( separator + 1 );
+		while( name->size() < length && std::cin ) {
+			std::string rest;
+			std::getline( std::cin, rest );
+			*name += "\n" + rest;
+		}
+		if( name->size() != length ) {
+			continue;
+		}
+		return static_cast<bool>( std::getline( std::cin, *command ) );
+	}
+	return false;
+}
+
+//! Runs command with the shell, printing its output as it comes, and returns its exit code
+int runJob( const std::string &command )
+{
+	// the jobs that follow are on the input of the server, the command mustn't read them
+#if defined( _WIN32 )
+	// cmd strips the outer quotes of the command line
+	std::string shellCommand = "\"" + command + " < NUL 2>&1\"";
+#else
+	std::string shellCommand = command + " < /dev/null 2>&1";
+#endif
+	FILE* pipe = popen( shellCommand.c_str(), "r" );
+	if( ! pipe ) {
+		std::cout << "rt-compile-server: failed to run " << command << std::endl;
+		return 1;
+	}
+	char buffer[4096];
+	size_t size;
+	while( ( size = fread( buffer, 1, sizeof( buffer ), pipe ) ) > 0 ) {
+		std::cout.write( buffer, size );
+		std::cout.flush();
+	}
+	int status = pclose( pipe );
+#if ! defined( _WIN32 )
+	status = WIFEXITED( status ) ? WEXITSTATUS( status ) : 1;
+#endif
+	return status;
+}
+
+int usage()
+{
+	std::cerr << "usage: rt-compile-server [--exit-during-job <n>] [--exit-before-ready]" << std::endl;
+	return 2;
+}
+
+} // anonymous namespace
+
+int main( int argc, char* argv[] )
+{
+	std::vector<std::string> args( argv + 1, argv + argc );
+	long exitDuringJob = 0;
+	bool exitBeforeReady = false;
+	for( size_t i = 0; i < args.size(); ++i ) {
+		if( args[i] == "--exit-during-job" && i + 1 < args.size() ) exitDuringJob = std::atol( args[++i].c_str() );
+		else if( args[i] == "--exit-before-ready" ) exitBeforeReady = true;
+		else return usage();
+	}
+
+	if( exitBeforeReady ) {
+		std::cout << "rt-compile-server: exiting before accepting jobs" << std::endl;
+		return 1;
+	}
+	std::cout << "@rt ready" << std::endl;
+
+	std::string name, command;
+	for( long job = 1; readJob( &name, &command ); ++job ) {
+		std::cout << "@rt begin " << name.size() << " " << name << std::endl;
+		if( job == exitDuringJob ) {
+			std::cout << "rt-compile-server: exiting during job " << job << std::endl;
+			return 1;
+		}
+		int status = runJob( command );
+		std::cout << "@rt end " << name.size() << " " << name << " " << status << std::endl;
+	}
+	return 0;
+}